@@ -0,0 +1,52 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "allocations.hpp"
+
+// Replaces the global operator new and delete (plain and aligned) to count allocations. They're kept in a file of their
+// own so the compiler can't inline them into code that also sees the standard declarations.
+
+static std::atomic<std::uint64_t> allocations{0};
+
+void* operator new(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size ? size : 1)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+// what std::pmr::new_delete_resource allocates with, and with it whatever spills out of an arena
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    const std::size_t align = static_cast<std::size_t>(alignment);
+    // aligned_alloc wants the size to be a multiple of the alignment
+    if (void* memory = std::aligned_alloc(align, (size + align - 1) / align * align + (size ? 0 : align))) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept {
+    std::free(memory);
+}
+
+/**
+ * @brief Returns how many allocations operator new has made so far, on every thread.
+ */
+std::uint64_t allocations_made() {
+    return allocations.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,8 @@
+#ifndef BENCH_ALLOCATIONS_HPP
+#define BENCH_ALLOCATIONS_HPP
+
+#include <cstdint>
+
+std::uint64_t allocations_made();
+
+#endif  // BENCH_ALLOCATIONS_HPP
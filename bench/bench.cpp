@@ -0,0 +1,694 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+#include <curl/curl.h>
+
+#include "allocations.hpp"
+#include "event.hpp"
+#include "event_cache.hpp"
+#include "event_store.hpp"
+#include "json_parser.hpp"
+#include "output.hpp"
+#include "parsing.hpp"
+#include "requests.hpp"
+#include "server.hpp"
+#include "trace.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+// how long each benchmark is repeated for, at least
+static const std::chrono::milliseconds MIN_DURATION(300);
+static const int MIN_RUNS = 5;
+// what libcurl passes to a write callback at most (CURL_MAX_WRITE_SIZE)
+static const std::size_t STREAM_CHUNK_SIZE = 16 * 1024;
+// how many requests a run of the fetch benchmarks makes, one after the other
+static const int FETCH_REQUESTS = 20;
+// how many events the cache benchmarks load, about a hundred pages' worth
+static const std::size_t CACHE_EVENTS = 10000;
+// how many events the output benchmarks write
+static const std::size_t OUTPUT_EVENTS = 100000;
+// how many events the memory measurement holds at once
+static const std::size_t HELD_EVENTS = 100000;
+
+// keeps the results of the benchmarked code from being optimized away
+static volatile std::size_t sink;
+
+/**
+ * @brief Starts measuring the peak resident set size over again from the current one (Linux only).
+ */
+static void reset_peak_rss() {
+    std::ofstream("/proc/self/clear_refs") << "5";
+}
+
+/**
+ * @brief Returns the peak resident set size since the last reset_peak_rss(), in KiB.
+ */
+static long peak_rss() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, 6, "VmHWM:") == 0) {
+            return std::atol(line.c_str() + 6);
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Returns how many bytes the heap has handed out and not gotten back (glibc only, 0 elsewhere).
+ */
+static std::size_t heap_in_use() {
+#if defined(__GLIBC__)
+    const struct mallinfo2 info = mallinfo2();
+    // small blocks come from the arena, big ones (like a vector of 100k events) are mapped of their own
+    return info.uordblks + info.hblkhd;
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief What a benchmark cost per event, averaged over its runs.
+ */
+struct Measurement {
+    double ns_per_event = 0;
+    double allocations_per_event = 0;
+    double seconds = 0;  // per run
+    long peak_rss = 0;   // KiB, over the benchmark's runs
+};
+
+/**
+ * @brief Runs a benchmark repeatedly, after one warm-up run, until it has taken long enough to time.
+ *
+ * @param events  How many events a run goes through.
+ * @param run     The benchmark.
+ */
+template <typename Run>
+static Measurement measure(std::size_t events, Run&& run) {
+    reset_peak_rss();
+    run();
+
+    const std::uint64_t allocations_before = allocations_made();
+    const Clock::time_point start = Clock::now();
+    int runs = 0;
+    Clock::duration elapsed;
+    do {
+        run();
+        ++runs;
+        elapsed = Clock::now() - start;
+    } while (runs < MIN_RUNS || elapsed < MIN_DURATION);
+    const std::uint64_t allocated = allocations_made() - allocations_before;
+
+    Measurement measurement;
+    const double total_events = (double)events * runs;
+    measurement.seconds = std::chrono::duration<double>(elapsed).count() / runs;
+    measurement.ns_per_event = std::chrono::duration<double, std::nano>(elapsed).count() / total_events;
+    measurement.allocations_per_event = (double)allocated / total_events;
+    measurement.peak_rss = peak_rss();
+    return measurement;
+}
+
+/**
+ * @brief Prints a benchmark's results as a row of the table.
+ *
+ * @param bytes  The size of the response a run went through, for its throughput; 0 if it didn't read one.
+ */
+static void print_row(const std::string& fixture, std::size_t events, const char* benchmark,
+                      const Measurement& measurement, std::size_t bytes) {
+    std::printf("%-20s %6zu  %-16s %10.1f  %10.0f  %12.2f  %9ld", fixture.c_str(), events, benchmark,
+                measurement.ns_per_event, 1e9 / measurement.ns_per_event, measurement.allocations_per_event,
+                measurement.peak_rss);
+    if (bytes > 0) {
+        std::printf("  %8.1f\n", (double)bytes / measurement.seconds / 1e6);
+    } else {
+        std::printf("  %8s\n", "-");
+    }
+}
+
+/**
+ * @brief Reads a recorded response.
+ *
+ * @return  Whether the file could be read.
+ */
+static bool read_response(const std::filesystem::path& path, std::string& body) {
+    std::ifstream file(path, std::ios::binary);
+    body.resize(std::filesystem::file_size(path));
+    if (!file.read(body.data(), body.size())) {
+        std::cerr << "Error: couldn't read " << path.string() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Benchmarks one recorded response: fetching it, parsing it (whole and in chunks), Event::to_str, and
+ *        rendering it in every output format.
+ *
+ * @param server        Stands in for the API, answering with the response.
+ * @param https_server  The same, over TLS.
+ * @return              Whether the response could be read and parsed.
+ */
+static bool bench_fixture(const std::filesystem::path& path, LocalServer& server, LocalServer& https_server) {
+    std::string body;
+    if (!read_response(path, body)) {
+        return false;
+    }
+
+    std::string error;
+    std::vector<Event> events;
+    if (!parse_json_response(body, [&](const Event& event) { events.push_back(event); }, &error)) {
+        std::cerr << "Error: couldn't parse " << path.string() << ": " << error << std::endl;
+        return false;
+    }
+    const std::string fixture = path.filename().string();
+
+    // the response, fetched over and over by a warm client that keeps its connection, and by one that
+    // opens a new connection for every request, in plain HTTP and then over TLS, where a new connection
+    // takes a handshake as well
+    server.set_body(body);
+    https_server.set_body(body);
+    const struct {
+        LocalServer& server;
+        bool reuse;
+        const char* name;
+    } connection_modes[] = {
+        {server, true, "fetch reused"},
+        {server, false, "fetch new conn"},
+        {https_server, true, "https reused"},
+        {https_server, false, "https new conn"},
+    };
+    for (const auto& [mode_server, reuse, name] : connection_modes) {
+        const std::string endpoint = mode_server.url() + "/users/octocat/events?per_page=100&page=1";
+        HttpClientOptions options;
+        options.reuse_connections = reuse;
+        options.ca_file = mode_server.certificate_file().string();
+        HttpClient client(options);
+        // a client that can't get through (e.g. one that doesn't trust the certificate) would look fast
+        if (!client.get(endpoint, [](const char*, std::size_t) {})) {
+            std::cerr << "Error: couldn't fetch " << endpoint << std::endl;
+            return false;
+        }
+        const Measurement fetch = measure(events.size() * FETCH_REQUESTS, [&] {
+            std::size_t received = 0;
+            for (int i = 0; i < FETCH_REQUESTS; ++i) {
+                client.get(endpoint, [&](const char*, std::size_t size) { received += size; });
+            }
+            sink = received;
+        });
+        print_row(fixture, events.size(), name, fetch, body.size() * FETCH_REQUESTS);
+    }
+
+    // the response, parsed into Events, then again with the parser's strings on the heap instead of in
+    // its scratch arena
+    static const std::pair<bool, const char*> parse_modes[] = {
+        {true, "parse"},
+        {false, "parse no arena"},
+    };
+    for (const auto& [arena, name] : parse_modes) {
+        set_parse_scratch_enabled(arena);
+        const Measurement parse = measure(events.size(), [&] {
+            std::size_t parsed = 0;
+            parse_json_response(body, [&](const Event&) { ++parsed; });
+            sink = parsed;
+        });
+        print_row(fixture, events.size(), name, parse, body.size());
+    }
+
+    // the same, fed to the incremental parser the way libcurl hands a response over
+    static const std::pair<bool, const char*> stream_modes[] = {
+        {true, "stream parse"},
+        {false, "stream no arena"},
+    };
+    for (const auto& [arena, name] : stream_modes) {
+        set_parse_scratch_enabled(arena);
+        const Measurement stream = measure(events.size(), [&] {
+            std::size_t parsed = 0;
+            EventStreamParser parser([&](const Event&) { ++parsed; });
+            for (std::size_t offset = 0; offset < body.size(); offset += STREAM_CHUNK_SIZE) {
+                parser.feed(body.data() + offset, std::min(STREAM_CHUNK_SIZE, body.size() - offset));
+            }
+            parser.finish();
+            sink = parsed;
+        });
+        print_row(fixture, events.size(), name, stream, body.size());
+    }
+    set_parse_scratch_enabled(true);
+
+    // the events, already parsed, as a sentence each
+    const Measurement to_str = measure(events.size(), [&] {
+        std::size_t size = 0;
+        for (const Event& event : events) size += event.to_str().size();
+        sink = size;
+    });
+    print_row(fixture, events.size(), "to_str", to_str, 0);
+
+    // the events, already parsed into a store, rendered the way the pipeline's workers do it
+    static const std::pair<OutputFormat, const char*> formats[] = {
+        {OutputFormat::Text, "render text"},
+        {OutputFormat::Ndjson, "render ndjson"},
+        {OutputFormat::Csv, "render csv"},
+        {OutputFormat::Binary, "render bin"},
+    };
+    EventStore store;
+    for (const Event& event : events) store.add(event);
+    std::string out;
+    for (const auto& [format, name] : formats) {
+        const Measurement render = measure(store.size(), [&] {
+            out.clear();
+            for (std::size_t i = 0; i < store.size(); ++i) {
+                append_event_record(out, format, store[i], "octocat", false, 0);
+            }
+            sink = out.size();
+        });
+        print_row(fixture, store.size(), name, render, 0);
+    }
+
+    return true;
+}
+
+/**
+ * @brief Makes one response out of the events of the recorded ones, repeated until there are enough of them.
+ *
+ * @param paths   The recorded responses.
+ * @param events  How many events it should have, at least.
+ * @param body    Set to the response.
+ * @return        Whether the responses could be read and had any events.
+ */
+static bool repeat_responses(const std::vector<std::filesystem::path>& paths, std::size_t events, std::string& body) {
+    // the events of every response, without the brackets around them
+    std::vector<std::pair<std::string, std::size_t>> event_lists;
+    for (const auto& path : paths) {
+        std::string response;
+        if (!read_response(path, response)) {
+            return false;
+        }
+        std::size_t count = 0;
+        parse_json_response(response, [&](const Event&) { ++count; });
+        const std::size_t first = response.find('[');
+        const std::size_t last = response.rfind(']');
+        if (count > 0 && first < last && last != std::string::npos) {
+            event_lists.emplace_back(response.substr(first + 1, last - first - 1), count);
+        }
+    }
+    if (event_lists.empty()) {
+        std::cerr << "Error: no events in the responses" << std::endl;
+        return false;
+    }
+
+    // one response with all of them, over and over
+    body = "[";
+    for (std::size_t i = 0, count = 0; count < events; i = (i + 1) % event_lists.size()) {
+        if (count > 0) body += ',';
+        body += event_lists[i].first;
+        count += event_lists[i].second;
+    }
+    body += ']';
+    return true;
+}
+
+/**
+ * @brief Benchmarks loading a page that hasn't changed: mapping its binary event cache against parsing
+ *        the cached response body again, which is what happens without one.
+ *
+ * Both load the same CACHE_EVENTS events, made by repeating the recorded responses' events, and then
+ * go through all of them. Every run opens the cache file anew, but the file stays in the page cache, so
+ * this times mapping and validating it, not the disk.
+ *
+ * @return  Whether the responses could be read and the cache written.
+ */
+static bool bench_event_cache(const std::vector<std::filesystem::path>& paths) {
+    std::string body;
+    if (!repeat_responses(paths, CACHE_EVENTS, body)) {
+        return false;
+    }
+
+    EventStore store;
+    parse_json_response(body, [&](const Event& event) { store.add(event); });
+    const std::string cache_path = (std::filesystem::temp_directory_path() / "github-activity-bench.events").string();
+    if (!write_event_cache(cache_path, store, "\"bench\"")) {
+        std::cerr << "Error: couldn't write " << cache_path << std::endl;
+        return false;
+    }
+    const std::size_t cache_size = std::filesystem::file_size(cache_path);
+
+    // what the fetcher does with a cache hit: map it, check its tag, and read the events in place
+    const Measurement open = measure(store.size(), [&] {
+        std::size_t size = 0;
+        MappedEventCache cache(cache_path);
+        if (cache.valid() && cache.tag() == "\"bench\"") {
+            for (std::size_t i = 0; i < cache.size(); ++i) size += cache[i].repo_name.size();
+        }
+        sink = size;
+    });
+    print_row("synthetic", store.size(), "cache open", open, cache_size);
+
+    // and without one: parse the cached response into a store, then read the events from it
+    EventStore parsed;
+    const Measurement reparse = measure(store.size(), [&] {
+        std::size_t size = 0;
+        parsed.clear();
+        parse_json_response(body, [&](const Event& event) { parsed.add(event); });
+        for (std::size_t i = 0; i < parsed.size(); ++i) size += parsed[i].repo_name.size();
+        sink = size;
+    });
+    print_row("synthetic", store.size(), "json reparse", reparse, body.size());
+
+    std::filesystem::remove(cache_path);
+    return true;
+}
+
+/**
+ * @brief Benchmarks writing OUTPUT_EVENTS events, made by repeating the recorded responses' events, as
+ *        text through an OutputWriter: line-buffered, with a write per line, and in blocks.
+ *
+ * The output goes to /dev/null, so this times formatting and the syscalls, not where the output ends up.
+ *
+ * @return  Whether the responses could be read and /dev/null opened.
+ */
+static bool bench_output_writer(const std::vector<std::filesystem::path>& paths) {
+    std::vector<Event> events;
+    for (const auto& path : paths) {
+        std::string response;
+        if (!read_response(path, response)) {
+            return false;
+        }
+        parse_json_response(response, [&](const Event& event) { events.push_back(event); });
+    }
+    if (events.empty()) {
+        std::cerr << "Error: no events in the responses" << std::endl;
+        return false;
+    }
+    EventStore store;
+    for (std::size_t i = 0; i < OUTPUT_EVENTS; ++i) store.add(events[i % events.size()]);
+
+    const int fd = open("/dev/null", O_WRONLY);
+    if (fd < 0) {
+        std::cerr << "Error: couldn't open /dev/null" << std::endl;
+        return false;
+    }
+
+    static const std::pair<bool, const char*> modes[] = {
+        {true, "write lines"},
+        {false, "write blocks"},
+    };
+    for (const auto& [line_buffered, name] : modes) {
+        const Measurement write = measure(store.size(), [&] {
+            OutputWriter out(fd, line_buffered);
+            for (std::size_t i = 0; i < store.size(); ++i) {
+                append_event_record(out.buffer(), OutputFormat::Text, store[i], "octocat", false, 0);
+                out.end_line();
+            }
+            out.flush();
+            sink = out.syscalls();
+        });
+        print_row("synthetic", store.size(), name, write, 0);
+    }
+
+    close(fd);
+    return true;
+}
+
+/**
+ * @brief An nghttpx process in front of the stand-in for the API, terminating TLS and speaking HTTP/2 (or
+ *        HTTP/1.1, whichever the client negotiates) to clients, and HTTP/1.1 to the stand-in.
+ */
+struct Http2Proxy {
+    pid_t pid = -1;
+    std::string url;
+
+    Http2Proxy() = default;
+    Http2Proxy(const Http2Proxy&) = delete;
+    Http2Proxy& operator=(const Http2Proxy&) = delete;
+
+    ~Http2Proxy() {
+        if (pid > 0) {
+            kill(pid, SIGTERM);
+            waitpid(pid, nullptr, 0);
+        }
+    }
+};
+
+/**
+ * @brief Finds a port on 127.0.0.1 that nothing listens on (for now).
+ */
+static int free_port() {
+    const int probe = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(address);
+    const bool bound = probe >= 0 && bind(probe, (sockaddr*)&address, sizeof(address)) == 0 &&
+                       getsockname(probe, (sockaddr*)&address, &length) == 0;
+    if (probe >= 0) close(probe);
+    return bound ? ntohs(address.sin_port) : 0;
+}
+
+/**
+ * @brief Starts nghttpx, from the PATH, in front of a stand-in for the API.
+ *
+ * @param backend      The stand-in to pass requests on to, in plain HTTP.
+ * @param certificate  A stand-in over TLS, whose certificate and key the proxy presents.
+ * @return             Whether the proxy is up and listening.
+ */
+static bool start_http2_proxy(Http2Proxy& proxy, const LocalServer& backend, const LocalServer& certificate) {
+    const int port = free_port();
+    const std::string backend_url = backend.url();
+    std::vector<std::string> arguments = {
+        "nghttpx",
+        "--conf=/dev/null",
+        "--frontend=127.0.0.1," + std::to_string(port),
+        "--backend=127.0.0.1," + backend_url.substr(backend_url.rfind(':') + 1),
+        "--workers=1",
+        "--no-ocsp",
+        "--log-level=FATAL",
+        certificate.key_file().string(),
+        certificate.certificate_file().string(),
+    };
+    std::vector<char*> argv;
+    for (std::string& argument : arguments) argv.push_back(argument.data());
+    argv.push_back(nullptr);
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+    posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+    const int spawned = port ? posix_spawnp(&proxy.pid, "nghttpx", &actions, nullptr, argv.data(), environ) : -1;
+    posix_spawn_file_actions_destroy(&actions);
+    if (spawned != 0) {
+        proxy.pid = -1;
+        return false;
+    }
+
+    // up once it accepts connections, for which it gets a few seconds
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+    for (int attempt = 0; attempt < 250; ++attempt) {
+        if (waitpid(proxy.pid, nullptr, WNOHANG) == proxy.pid) {
+            proxy.pid = -1;
+            return false;
+        }
+        const int probe = socket(AF_INET, SOCK_STREAM, 0);
+        const bool connected = probe >= 0 && connect(probe, (sockaddr*)&address, sizeof(address)) == 0;
+        if (probe >= 0) close(probe);
+        if (connected) {
+            proxy.url = "https://127.0.0.1:" + std::to_string(port);
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    return false;
+}
+
+/**
+ * @brief Benchmarks concurrent requests over HTTP/1.1, a connection each, against HTTP/2, multiplexed over one,
+ *        through an nghttpx proxy in front of the stand-in for the API. Skipped without nghttpx on the PATH,
+ *        or a libcurl without (working) HTTP/2.
+ *
+ * @param server        Stands in for the API, in plain HTTP.
+ * @param https_server  Stands in for it over TLS, lending the proxy its certificate.
+ */
+static bool bench_http2(const std::vector<std::filesystem::path>& paths, LocalServer& server,
+                        LocalServer& https_server) {
+    // libcurl 7.88 leaves multiplexed transfers stalled for good after a few hundred streams over one
+    // connection, where 8.14 doesn't; the HTTP/2 rework in 8.1 is the oldest it's expected to run on
+    if (curl_version_info(CURLVERSION_NOW)->version_num < 0x080100) {
+        std::cerr << "Warning: libcurl " << curl_version_info(CURLVERSION_NOW)->version
+                  << " stalls multiplexing, skipping the HTTP/2 benchmarks" << std::endl;
+        return true;
+    }
+    Http2Proxy proxy;
+    if (!start_http2_proxy(proxy, server, https_server)) {
+        std::cerr << "Warning: couldn't start nghttpx, skipping the HTTP/2 benchmarks" << std::endl;
+        return true;
+    }
+    const std::string endpoint = proxy.url + "/users/octocat/events?per_page=100&page=1";
+
+    static const std::pair<bool, const char*> modes[] = {
+        {false, "h1.1 8 at once"},
+        {true, "h2 8 at once"},
+    };
+    // a libcurl without HTTP/2 would quietly time HTTP/1.1 twice, so each mode's protocol is checked in
+    // the trace of a request made with it first
+    const std::filesystem::path trace_path = std::filesystem::temp_directory_path() /
+                                             ("github-activity-bench-" + std::to_string(getpid()) + ".jsonl");
+    for (const auto& [http2, name] : modes) {
+        std::ifstream trace;
+        {
+            Tracer tracer(trace_path.string(), TraceFormat::Jsonl);
+            HttpClientOptions options;
+            options.http2 = http2;
+            options.ca_file = https_server.certificate_file().string();
+            options.tracer = &tracer;
+            HttpClient client(options);
+            if (!client.get(endpoint, [](const char*, std::size_t) {})) {
+                std::cerr << "Error: couldn't fetch " << endpoint << std::endl;
+                std::filesystem::remove(trace_path);
+                return false;
+            }
+        }
+        trace.open(trace_path);
+        const std::string recorded((std::istreambuf_iterator<char>(trace)), std::istreambuf_iterator<char>());
+        std::filesystem::remove(trace_path);
+        if (recorded.find(http2 ? "\"http_version\":\"2\"" : "\"http_version\":\"1.1\"") == std::string::npos) {
+            std::cerr << "Warning: the proxy wasn't spoken to in " << (http2 ? "HTTP/2" : "HTTP/1.1")
+                      << ", skipping the HTTP/2 benchmarks" << std::endl;
+            return true;
+        }
+    }
+
+    for (const auto& path : paths) {
+        std::string body;
+        if (!read_response(path, body)) {
+            return false;
+        }
+        std::size_t events = 0;
+        parse_json_response(body, [&](const Event&) { ++events; });
+        server.set_body(body);
+
+        for (const auto& [http2, name] : modes) {
+            HttpClientOptions options;
+            options.http2 = http2;
+            options.ca_file = https_server.certificate_file().string();
+            HttpClient client(options);
+            const Measurement fetch = measure(events * FETCH_REQUESTS, [&] {
+                std::size_t received = 0;
+                std::deque<HttpRequest> requests(FETCH_REQUESTS);
+                for (HttpRequest& request : requests) {
+                    request.endpoint = endpoint;
+                    request.on_data = [&](const char*, std::size_t size) { received += size; };
+                }
+                client.get_all(requests, 8);
+                sink = received;
+            });
+            print_row(path.filename().string(), events, name, fetch, body.size() * FETCH_REQUESTS);
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Measures the heap it takes to hold HELD_EVENTS events, made by repeating the recorded responses'
+ *        events, as a vector<Event> and as an EventStore.
+ *
+ * Both are trimmed to their size first, so this is what they hold rather than how they grew. Printed as
+ * a table of its own, in bytes per event.
+ *
+ * @return  Whether the responses could be read and had any events.
+ */
+static bool measure_held_events(const std::vector<std::filesystem::path>& paths) {
+    std::vector<Event> events;
+    for (const auto& path : paths) {
+        std::string response;
+        if (!read_response(path, response)) {
+            return false;
+        }
+        parse_json_response(response, [&](const Event& event) { events.push_back(event); });
+    }
+    if (events.empty()) {
+        std::cerr << "Error: no events in the responses" << std::endl;
+        return false;
+    }
+
+    std::printf("\n%-20s %6s  %-16s %11s\n", "held in memory", "events", "container", "bytes/event");
+
+    std::size_t before = heap_in_use();
+    {
+        std::vector<Event> held;
+        held.reserve(HELD_EVENTS);
+        for (std::size_t i = 0; i < HELD_EVENTS; ++i) held.push_back(events[i % events.size()]);
+        const double bytes = (double)(heap_in_use() - before) / HELD_EVENTS;
+        std::printf("%-20s %6zu  %-16s %11.1f\n", "synthetic", held.size(), "vector<Event>", bytes);
+    }
+
+    before = heap_in_use();
+    {
+        EventStore held;
+        for (std::size_t i = 0; i < HELD_EVENTS; ++i) held.add(events[i % events.size()]);
+        held.shrink_to_fit();
+        const double bytes = (double)(heap_in_use() - before) / HELD_EVENTS;
+        std::printf("%-20s %6zu  %-16s %11.1f\n", "synthetic", held.size(), "EventStore", bytes);
+    }
+
+    return true;
+}
+
+/**
+ * @brief Benchmarks the parser and renderers on recorded responses.
+ *
+ * Usage: bench <response.json>...
+ *
+ * Every benchmark gets a row per response with its time per event (and events per second), its
+ * allocations per event, the peak resident set size while it ran (the whole process's, fixtures
+ * included) and how fast it went through the response. The last rows go through many more events,
+ * made by repeating those of all the responses: loading them from a binary event cache against
+ * parsing them again, and writing them out line by line against in blocks. A last table gives the
+ * memory it takes to hold 100k of those events as Events and in an EventStore.
+ */
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <response.json>..." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::printf("%-20s %6s  %-16s %10s  %10s  %12s  %9s  %8s\n", "fixture", "events", "benchmark", "ns/event",
+                "events/s", "allocs/event", "peak KiB", "MB/s in");
+    LocalServer server;
+    LocalServer https_server(LocalServer::Scheme::Https);
+    std::vector<std::filesystem::path> paths(argv + 1, argv + argc);
+    for (const auto& path : paths) {
+        if (!bench_fixture(path, server, https_server)) {
+            return EXIT_FAILURE;
+        }
+    }
+    if (!bench_http2(paths, server, https_server) || !bench_event_cache(paths) || !bench_output_writer(paths) ||
+        !measure_held_events(paths)) {
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,411 @@
+#include <cctype>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/x509v3.h>
+
+#include "server.hpp"
+
+/**
+ * @brief The reason phrase for the statuses the API answers with.
+ */
+static std::string_view reason_phrase(int status) {
+    switch (status) {
+        case 200: return "OK";
+        case 304: return "Not Modified";
+        case 403: return "Forbidden";
+        case 404: return "Not Found";
+        case 429: return "Too Many Requests";
+        case 500: return "Internal Server Error";
+        default: return "Unknown";
+    }
+}
+
+/**
+ * @brief Splits a request's head (request line and headers, without the blank line that ends it) up.
+ */
+static LocalServer::Request parse_request(std::string_view head) {
+    LocalServer::Request request;
+
+    size_t end = head.find("\r\n");
+    const std::string_view request_line = head.substr(0, end);
+    const size_t method_end = request_line.find(' ');
+    const size_t target_end = request_line.find(' ', method_end + 1);
+    request.method = request_line.substr(0, method_end);
+    if (method_end != std::string_view::npos) {
+        request.target = request_line.substr(method_end + 1, target_end - method_end - 1);
+    }
+
+    while (end != std::string_view::npos) {
+        head.remove_prefix(end + 2);
+        end = head.find("\r\n");
+        const std::string_view line = head.substr(0, end);
+        const size_t colon = line.find(':');
+        if (colon == std::string_view::npos) {
+            continue;
+        }
+
+        std::string name(line.substr(0, colon));
+        for (char& c : name) {
+            c = (char)std::tolower((unsigned char)c);
+        }
+        std::string_view value = line.substr(colon + 1);
+        const size_t first = value.find_first_not_of(" \t");
+        value = (first == std::string_view::npos) ? std::string_view() : value.substr(first);
+        request.headers.emplace_back(std::move(name), value);
+    }
+
+    return request;
+}
+
+/**
+ * @brief Serializes a scripted response.
+ */
+static std::string format_response(const LocalServer::Response& response) {
+    std::string message = "HTTP/1.1 " + std::to_string(response.status) + " ";
+    message += reason_phrase(response.status);
+    message += "\r\n";
+    for (const auto& [name, value] : response.headers) {
+        message += name + ": " + value + "\r\n";
+    }
+    message += "content-length: " + std::to_string(response.body.size()) + "\r\n\r\n";
+    message += response.body;
+    return message;
+}
+
+/**
+ * @brief Finds a header in a request's head without copying it.
+ *
+ * @param name  The header's name in lowercase.
+ * @return      Its value, or an empty one if the request didn't have it.
+ */
+static std::string_view find_header(std::string_view head, std::string_view name) {
+    size_t end = head.find("\r\n");
+    while (end != std::string_view::npos) {
+        head.remove_prefix(end + 2);
+        end = head.find("\r\n");
+        const std::string_view line = head.substr(0, end);
+        if (line.size() <= name.size() || line[name.size()] != ':') {
+            continue;
+        }
+        bool matches = true;
+        for (size_t i = 0; i < name.size() && matches; ++i) {
+            matches = std::tolower((unsigned char)line[i]) == name[i];
+        }
+        if (matches) {
+            const std::string_view value = line.substr(name.size() + 1);
+            const size_t first = value.find_first_not_of(" \t");
+            return first == std::string_view::npos ? std::string_view() : value.substr(first);
+        }
+    }
+    return {};
+}
+
+/**
+ * @brief A strong ETag for a body: its 64-bit FNV-1a hash, quoted.
+ */
+static std::string make_etag(std::string_view body) {
+    std::uint64_t hash = 14695981039346656037ull;
+    for (const char c : body) {
+        hash = (hash ^ (unsigned char)c) * 1099511628211ull;
+    }
+    char etag[19];
+    std::snprintf(etag, sizeof(etag), "\"%016llx\"", (unsigned long long)hash);
+    return etag;
+}
+
+/**
+ * @brief Adds an X.509 v3 extension, given the way a config file would, to a self-signed certificate.
+ */
+static bool add_extension(X509* certificate, int nid, const char* value) {
+    X509V3_CTX context;
+    X509V3_set_ctx_nodb(&context);
+    X509V3_set_ctx(&context, certificate, certificate, nullptr, nullptr, 0);
+    X509_EXTENSION* extension = X509V3_EXT_conf_nid(nullptr, &context, nid, value);
+    if (!extension) {
+        return false;
+    }
+    const bool added = X509_add_ext(certificate, extension, -1);
+    X509_EXTENSION_free(extension);
+    return added;
+}
+
+static bool send_all(int client, SSL* ssl, std::string_view data) {
+    while (!data.empty()) {
+        const ssize_t count = ssl ? SSL_write(ssl, data.data(), (int)data.size())
+                                  : send(client, data.data(), data.size(), MSG_NOSIGNAL);
+        if (count <= 0) {
+            return false;
+        }
+        data.remove_prefix(count);
+    }
+    return true;
+}
+
+/**
+ * @brief Looks a header up by its name in lowercase.
+ *
+ * @return  The header's value, or an empty one if the request didn't have it.
+ */
+std::string_view LocalServer::Request::header(std::string_view name) const {
+    for (const auto& [header_name, value] : headers) {
+        if (header_name == name) {
+            return value;
+        }
+    }
+    return {};
+}
+
+/**
+ * @brief Starts listening on an ephemeral port of 127.0.0.1.
+ *
+ * @param scheme  Whether to speak plain HTTP, or HTTPS with a certificate of its own.
+ */
+LocalServer::LocalServer(Scheme scheme) {
+    if (scheme == Scheme::Https) {
+        // OpenSSL writes to its sockets without MSG_NOSIGNAL, so a client that goes away mid-response
+        // would otherwise take the whole process down with it
+        std::signal(SIGPIPE, SIG_IGN);
+        make_certificate();
+    }
+
+    // neither it nor the connections are handed down to processes the benchmarks start
+    listener = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listener < 0) {
+        throw std::runtime_error("couldn't create a socket");
+    }
+
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0;
+    socklen_t length = sizeof(address);
+    if (bind(listener, (sockaddr*)&address, sizeof(address)) != 0 || listen(listener, 64) != 0 ||
+        getsockname(listener, (sockaddr*)&address, &length) != 0) {
+        close(listener);
+        SSL_CTX_free(tls);
+        throw std::runtime_error("couldn't listen on 127.0.0.1");
+    }
+    port = ntohs(address.sin_port);
+
+    set_body("[]");
+    acceptor = std::thread(&LocalServer::accept_loop, this);
+}
+
+LocalServer::~LocalServer() {
+    stopping = true;
+    // wakes the acceptor up, then every connection waiting for its next request
+    shutdown(listener, SHUT_RDWR);
+    acceptor.join();
+    close(listener);
+
+    for (Connection& connection : open_connections) {
+        shutdown(connection.client, SHUT_RDWR);
+        connection.thread.join();
+        close_connection(connection);
+    }
+
+    SSL_CTX_free(tls);
+    if (!certificate_directory.empty()) {
+        std::error_code error;
+        std::filesystem::remove_all(certificate_directory, error);
+    }
+}
+
+/**
+ * @brief Makes a self-signed certificate for 127.0.0.1 (with a P-256 key, valid for a day) to serve TLS
+ *        with, and writes it and its key out for clients and other servers to use.
+ */
+void LocalServer::make_certificate() {
+    std::string directory = (std::filesystem::temp_directory_path() / "github-activity-server.XXXXXX").string();
+    if (!mkdtemp(directory.data())) {
+        throw std::runtime_error("couldn't create a directory for the server's certificate");
+    }
+    certificate_directory = directory;
+    certificate_path = certificate_directory / "certificate.pem";
+    key_path = certificate_directory / "key.pem";
+
+    EVP_PKEY* key = EVP_EC_gen("P-256");
+    X509* certificate = X509_new();
+    bool made = key && certificate;
+    if (made) {
+        // its own CA, so that trusting it as one is all a client has to do
+        X509_set_version(certificate, X509_VERSION_3);
+        ASN1_INTEGER_set(X509_get_serialNumber(certificate), 1);
+        X509_gmtime_adj(X509_getm_notBefore(certificate), -60);
+        X509_gmtime_adj(X509_getm_notAfter(certificate), 24 * 60 * 60);
+        X509_NAME* name = X509_get_subject_name(certificate);
+        X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, (const unsigned char*)"127.0.0.1", -1, -1, 0);
+        X509_set_issuer_name(certificate, name);
+        made = X509_set_pubkey(certificate, key) &&
+               add_extension(certificate, NID_basic_constraints, "critical,CA:TRUE") &&
+               add_extension(certificate, NID_subject_alt_name, "IP:127.0.0.1") &&
+               X509_sign(certificate, key, EVP_sha256()) > 0;
+    }
+    if (made) {
+        FILE* certificate_out = std::fopen(certificate_path.c_str(), "w");
+        FILE* key_out = std::fopen(key_path.c_str(), "w");
+        made = certificate_out && key_out && PEM_write_X509(certificate_out, certificate) &&
+               PEM_write_PrivateKey(key_out, key, nullptr, nullptr, 0, nullptr, nullptr);
+        if (certificate_out) made = std::fclose(certificate_out) == 0 && made;
+        if (key_out) made = std::fclose(key_out) == 0 && made;
+    }
+    if (made) {
+        tls = SSL_CTX_new(TLS_server_method());
+        made = tls && SSL_CTX_use_certificate(tls, certificate) && SSL_CTX_use_PrivateKey(tls, key);
+    }
+
+    X509_free(certificate);
+    EVP_PKEY_free(key);
+    if (!made) {
+        SSL_CTX_free(tls);
+        std::error_code error;
+        std::filesystem::remove_all(certificate_directory, error);
+        throw std::runtime_error("couldn't make a TLS certificate for the server");
+    }
+}
+
+/**
+ * @brief Sets the body every request is answered with from now on, with a 200 (or a 304 for a request
+ *        that already has it).
+ */
+void LocalServer::set_body(std::string body) {
+    auto next = std::make_shared<Prepared>();
+    next->etag = make_etag(body);
+    next->response = "HTTP/1.1 200 OK\r\ncontent-type: application/json; charset=utf-8\r\netag: " + next->etag +
+                     "\r\ncontent-length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+    next->not_modified = "HTTP/1.1 304 Not Modified\r\netag: " + next->etag + "\r\n\r\n";
+
+    std::lock_guard<std::mutex> lock(response_mutex);
+    prepared = std::move(next);
+}
+
+/**
+ * @brief Scripts the responses: from now on, every request is answered with what the handler returns.
+ *
+ * The handler is called from the connections' threads, possibly concurrently. An empty one goes back
+ * to answering with the body.
+ */
+void LocalServer::set_handler(Handler next) {
+    auto shared = next ? std::make_shared<const Handler>(std::move(next)) : nullptr;
+
+    std::lock_guard<std::mutex> lock(response_mutex);
+    handler = std::move(shared);
+}
+
+/**
+ * @brief The base URL to send requests to, e.g. http://127.0.0.1:40000.
+ */
+std::string LocalServer::url() const {
+    return (tls ? "https://127.0.0.1:" : "http://127.0.0.1:") + std::to_string(port);
+}
+
+void LocalServer::accept_loop() {
+    while (!stopping) {
+        const int client = accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+        if (client < 0) {
+            continue;
+        }
+        ++accepted;
+        // a response over TLS goes out as a record per 16 KiB, and waiting to send each one until the last
+        // was acknowledged stalls on the client's delayed ACKs
+        const int no_delay = 1;
+        setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+
+        std::lock_guard<std::mutex> lock(connections_mutex);
+        // connections the client has closed since are done with
+        std::erase_if(open_connections, [](Connection& connection) {
+            if (!connection.done) return false;
+            connection.thread.join();
+            close_connection(connection);
+            return true;
+        });
+
+        Connection& connection = open_connections.emplace_back();
+        connection.client = client;
+        if (tls) {
+            connection.ssl = SSL_new(tls);
+            if (connection.ssl) SSL_set_fd(connection.ssl, client);
+        }
+        connection.thread = std::thread(&LocalServer::serve, this, std::ref(connection));
+    }
+}
+
+// answers requests on a connection until the client closes it
+void LocalServer::serve(Connection& connection) {
+    // the handshake is done here rather than on accepting, so a slow one only holds its own connection up
+    if (tls && (!connection.ssl || SSL_accept(connection.ssl) != 1)) {
+        connection.done = true;
+        return;
+    }
+
+    char buffer[16 * 1024];
+    size_t buffered = 0;
+    while (!stopping) {
+        const ssize_t received =
+            connection.ssl ? SSL_read(connection.ssl, buffer + buffered, (int)(sizeof(buffer) - buffered))
+                           : recv(connection.client, buffer + buffered, sizeof(buffer) - buffered, 0);
+        if (received <= 0) {
+            break;
+        }
+        buffered += received;
+
+        // requests are GETs without a body, so each one ends with its headers
+        size_t end;
+        bool sent = true;
+        while (sent && (end = std::string_view(buffer, buffered).find("\r\n\r\n")) != std::string_view::npos) {
+            sent = answer(connection, std::string_view(buffer, end));
+            buffered -= end + 4;
+            std::memmove(buffer, buffer + end + 4, buffered);
+        }
+        if (!sent || buffered == sizeof(buffer)) {
+            break;  // the client went away, or sent a request too big to be one of ours
+        }
+    }
+    connection.done = true;
+}
+
+void LocalServer::close_connection(Connection& connection) {
+    SSL_free(connection.ssl);
+    close(connection.client);
+}
+
+/**
+ * @brief Sends the response to one request.
+ *
+ * @param connection  The connection the request came in on.
+ * @param head        The request's line and headers.
+ * @return            Whether the response was sent.
+ */
+bool LocalServer::answer(Connection& connection, std::string_view head) {
+    std::shared_ptr<const Prepared> current_prepared;
+    std::shared_ptr<const Handler> current_handler;
+    {
+        std::lock_guard<std::mutex> lock(response_mutex);
+        current_prepared = prepared;
+        current_handler = handler;
+    }
+
+    ++answered;
+    if (!current_handler) {
+        if (find_header(head, "if-none-match") == current_prepared->etag) {
+            ++answered_not_modified;
+            return send_all(connection.client, connection.ssl, current_prepared->not_modified);
+        }
+        return send_all(connection.client, connection.ssl, current_prepared->response);
+    }
+    return send_all(connection.client, connection.ssl, format_response((*current_handler)(parse_request(head))));
+}
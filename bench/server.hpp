@@ -0,0 +1,111 @@
+#ifndef BENCH_SERVER_HPP
+#define BENCH_SERVER_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <openssl/ssl.h>
+
+/**
+ * @brief A stand-in for the API on the loopback interface, for benchmarking and checking the HTTP client
+ * without the network.
+ *
+ * Speaks HTTP/1.1, in plain text or over TLS, and keeps connections alive until the client closes
+ * them, serving each connection on a thread of its own. Over TLS, it presents a self-signed
+ * certificate for 127.0.0.1 that it makes when it starts, which clients have to be given to trust
+ * (e.g. as their CA file). By default every GET is answered with the same 200 response
+ * body, tagged with an ETag of it: a request with a matching If-None-Match gets a 304 instead, as
+ * from the API. A handler can script each response's status and headers instead.
+ */
+class LocalServer {
+public:
+    /**
+     * @brief A request as the server received it.
+     */
+    struct Request {
+        std::string method;
+        std::string target;  // path and query, e.g. /users/alice/events?page=2
+        std::vector<std::pair<std::string, std::string>> headers;  // names in lowercase
+
+        std::string_view header(std::string_view name) const;
+    };
+
+    /**
+     * @brief A response for a handler to script.
+     */
+    struct Response {
+        int status = 200;
+        std::vector<std::pair<std::string, std::string>> headers;  // content-length is added
+        std::string body;
+    };
+
+    using Handler = std::function<Response(const Request& request)>;
+
+    enum class Scheme { Http, Https };
+
+    explicit LocalServer(Scheme scheme = Scheme::Http);
+    ~LocalServer();
+
+    LocalServer(const LocalServer&) = delete;
+    LocalServer& operator=(const LocalServer&) = delete;
+
+    void set_body(std::string body);
+    void set_handler(Handler handler);
+    std::string url() const;
+    const std::filesystem::path& certificate_file() const { return certificate_path; }
+    const std::filesystem::path& key_file() const { return key_path; }
+    size_t connections() const { return accepted.load(); }
+    size_t requests() const { return answered.load(); }
+    size_t not_modified() const { return answered_not_modified.load(); }
+
+private:
+    // the answers to requests for the body, prepared once for all of them
+    struct Prepared {
+        std::string etag;
+        std::string response;
+        std::string not_modified;
+    };
+
+    struct Connection {
+        int client = -1;
+        SSL* ssl = nullptr;  // over TLS
+        std::thread thread;
+        std::atomic<bool> done{false};
+    };
+
+    void make_certificate();
+    void accept_loop();
+    void serve(Connection& connection);
+    bool answer(Connection& connection, std::string_view request);
+    static void close_connection(Connection& connection);
+
+    int listener = -1;
+    int port = 0;
+    SSL_CTX* tls = nullptr;  // when serving over TLS
+    std::filesystem::path certificate_directory;
+    std::filesystem::path certificate_path;  // PEM, of the certificate and of its private key
+    std::filesystem::path key_path;
+    std::atomic<bool> stopping{false};
+    std::atomic<size_t> accepted{0};
+    std::atomic<size_t> answered{0};
+    std::atomic<size_t> answered_not_modified{0};
+    std::mutex connections_mutex;
+    std::list<Connection> open_connections;
+    std::mutex response_mutex;
+    // swapped as a whole, so a connection can keep sending the one it took while the next is set
+    std::shared_ptr<const Prepared> prepared;
+    std::shared_ptr<const Handler> handler;
+    std::thread acceptor;
+};
+
+#endif  // BENCH_SERVER_HPP
@@ -0,0 +1,54 @@
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+
+/**
+ * @brief A monotonic arena for short-lived scratch memory that is dropped all at once.
+ *
+ * Allocations are carved out of one retained buffer by a std::pmr::monotonic_buffer_resource, and
+ * freeing them individually does nothing. reset() gives the whole buffer back in O(1), ready for the
+ * next round, so a thread that keeps reusing the arena stops calling malloc once the buffer is big
+ * enough. Whatever doesn't fit spills to the heap; the next reset() then grows the buffer to hold it
+ * all, so the spill only happens while the arena is warming up to its largest round. The buffer
+ * stops growing at max_capacity: a round bigger than that (a page with a huge string in it, say)
+ * spills to the heap every time instead of pinning its size for the thread's lifetime.
+ */
+class ScratchArena {
+public:
+    static constexpr size_t default_capacity = 64 * 1024;
+    static constexpr size_t max_capacity = 1024 * 1024;
+
+    explicit ScratchArena(size_t capacity = default_capacity);
+
+    ScratchArena(const ScratchArena&) = delete;
+    ScratchArena& operator=(const ScratchArena&) = delete;
+
+    std::pmr::memory_resource& resource() { return *arena; }
+    void reset();
+    size_t capacity() const { return buffer_size; }
+
+private:
+    /**
+     * @brief Hands the arena's overflow on to the heap, keeping track of how much there was.
+     */
+    class Overflow : public std::pmr::memory_resource {
+    public:
+        size_t bytes = 0;  // allocated since the last reset
+
+    private:
+        void* do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void* pointer, size_t bytes, size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+    };
+
+    std::unique_ptr<std::byte[]> buffer;
+    size_t buffer_size;
+    Overflow overflow;
+    std::optional<std::pmr::monotonic_buffer_resource> arena;
+};
+
+#endif  // ARENA_HPP
@@ -0,0 +1,41 @@
+#ifndef CACHE_HPP
+#define CACHE_HPP
+
+#include <optional>
+#include <string>
+
+/**
+ * @brief A cached API response, with the validators needed to revalidate it.
+ */
+struct CachedResponse {
+    std::string etag;
+    std::string last_modified;
+    std::string link;  // pagination header, which a 304 doesn't necessarily repeat
+    std::string body;
+};
+
+/**
+ * @brief On-disk cache of API responses, keyed by endpoint URL.
+ *
+ * Lets HttpClient make conditional requests (If-None-Match / If-Modified-Since). When the server
+ * answers 304 Not Modified, the cached body is used instead, so repeat polls cost next to nothing
+ * in transfer and don't count against the rate limit.
+ */
+class ResponseCache {
+public:
+    explicit ResponseCache(std::string directory);
+
+    static std::string default_directory();
+
+    std::optional<CachedResponse> load(const std::string& endpoint, bool with_body = true) const;
+    void store(const std::string& endpoint, const CachedResponse& response) const;
+
+    std::string events_path(const std::string& endpoint) const;
+
+private:
+    std::string path_for(const std::string& endpoint, const char* extension) const;
+
+    std::string directory;
+};
+
+#endif  // CACHE_HPP
@@ -1,21 +1,86 @@
 #ifndef EVENT_HPP
 #define EVENT_HPP
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <optional>
 #include <vector>
 
+struct EventView;
+
+/**
+ * @brief The type of a Github event, interned from its `type` string at parse time.
+ */
+enum class EventType : std::uint8_t {
+    Unknown,  // the raw type string is kept alongside
+    CommitComment,
+    Create,
+    Delete,
+    Fork,
+    Gollum,
+    IssueComment,
+    Issues,
+    Member,
+    Public,
+    PullRequest,
+    PullRequestReview,
+    PullRequestReviewComment,
+    PullRequestReviewThread,
+    Push,
+    Release,
+    Sponsorship,
+    Watch,
+    Count
+};
+
+/**
+ * @brief The action of a Github event's payload, interned from its `action` string at parse time.
+ */
+enum class EventAction : std::uint8_t {
+    None,     // the payload has no action
+    Unknown,  // the raw action string is kept alongside
+    Added,
+    Assigned,
+    Closed,
+    Created,
+    Deleted,
+    Edited,
+    Labeled,
+    Opened,
+    Published,
+    Reopened,
+    Resolved,
+    ReviewRequestRemoved,
+    ReviewRequested,
+    Started,
+    Synchronize,
+    Unassigned,
+    Unlabeled,
+    Unresolved,
+    Count
+};
+
+EventType event_type_from_string(std::string_view type);
+EventAction event_action_from_string(std::string_view action);
+std::string_view to_string(EventType type);
+std::string_view to_string(EventAction action);
+
 /**
  * @brief Represents a Github event.
  */
 struct Event {
-    std::string type;
-    std::string time;
+    std::uint64_t id = 0;  // increases with every event Github records
+    EventType type = EventType::Unknown;
+    std::string type_name;  // raw type, only kept if it's Unknown
+    std::int64_t time = 0;  // created_at, in seconds since the Unix epoch
     std::string repo_name;
     std::optional<int> issue_number;
     std::optional<int> pr_number;
     std::optional<int> commit_count; // # of commits in push
-    std::optional<std::string> action;       // action taken (create, edit, delete, etc.)
+    EventAction action = EventAction::None;  // action taken (create, edit, delete, etc.)
+    std::string action_name;                 // raw action, only kept if it's Unknown
     std::optional<std::string> assignee;     // username of user assigned to issue/PR
     std::optional<std::string> label;        // label added to/removed from issue/PR
     std::optional<std::string> collaborator; // username of collaborator added to repo
@@ -23,6 +88,39 @@ struct Event {
     std::optional<std::vector<std::string>> requested_reviewers;  // usernames
 
     std::string to_str() const;
+    EventView view(std::string& reviewer_buffer) const;
+    void clear();
+};
+
+/**
+ * @brief Non-owning view of a Github event's fields.
+ *
+ * Lets events be rendered straight out of storage that isn't an Event, like a memory-mapped
+ * event cache, without copying their strings onto the heap first.
+ */
+struct EventView {
+    std::uint64_t id;
+    EventType type;
+    std::string_view type_name;
+    std::int64_t time;
+    std::string_view repo_name;
+    std::optional<int> issue_number;
+    std::optional<int> pr_number;
+    std::optional<int> commit_count;
+    EventAction action;
+    std::string_view action_name;
+    std::optional<std::string_view> assignee;
+    std::optional<std::string_view> label;
+    std::optional<std::string_view> collaborator;
+    std::optional<std::string_view> pr_title;
+    std::optional<std::string_view> requested_reviewers;  // usernames, separated by commas
+
+    std::string to_str() const;
+    void append_to(std::string& out) const;
+    std::string_view type_str() const;
+    std::string_view action_str() const;
+    size_t reviewer_count() const;
+    std::string_view reviewer(size_t index) const;
 };
 
 #endif  // EVENT_HPP
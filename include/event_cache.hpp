@@ -0,0 +1,68 @@
+#ifndef EVENT_CACHE_HPP
+#define EVENT_CACHE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "event_store.hpp"
+
+/*
+ * Binary event cache format (native byte order, it's a machine-local cache):
+ *
+ *   EventCacheHeader
+ *   PackedEvent[event_count]
+ *   string blob (strings_size bytes)
+ *
+ * This is an EventStore written out as is: every string is a StringRef into the blob, and the optional
+ * fields of an event are flagged in its `present` bitmask. The file is meant to be mmap'd and read in
+ * place.
+ */
+
+/**
+ * @brief Leads a binary event cache file.
+ */
+struct EventCacheHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t event_count;
+    StringRef tag;  // what the events were cached from, e.g. the response's ETag
+    std::uint64_t strings_size;
+};
+
+bool write_event_cache(const std::string& path, const EventStore& events, std::string_view tag);
+
+/**
+ * @brief Read-only, memory-mapped binary event cache.
+ *
+ * Events are read in place: the views it hands out point straight into the mapping, so loading a
+ * cache costs one mmap and a bounds check per record, no matter how many events it holds.
+ */
+class MappedEventCache {
+public:
+    explicit MappedEventCache(const std::string& path);
+    ~MappedEventCache();
+
+    MappedEventCache(const MappedEventCache&) = delete;
+    MappedEventCache& operator=(const MappedEventCache&) = delete;
+
+    bool valid() const { return header != nullptr; }
+    size_t size() const { return header ? header->event_count : 0; }
+    std::string_view tag() const;
+
+    EventView operator[](size_t index) const;
+
+private:
+    bool validate() const;
+    std::string_view string_at(StringRef ref) const;
+
+    void* mapping = nullptr;
+    size_t mapping_size = 0;
+    const EventCacheHeader* header = nullptr;
+    const PackedEvent* records = nullptr;
+    const char* strings = nullptr;
+};
+
+#endif  // EVENT_CACHE_HPP
@@ -0,0 +1,150 @@
+#ifndef FETCHING_HPP
+#define FETCHING_HPP
+
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "cache.hpp"
+#include "event.hpp"
+#include "event_cache.hpp"
+#include "event_store.hpp"
+#include "filter.hpp"
+#include "parsing.hpp"
+#include "requests.hpp"
+#include "trace.hpp"
+
+/**
+ * @brief Settings for an EventFetcher run.
+ */
+struct FetchOptions {
+    std::string api_url = "https://api.github.com";
+    size_t max_in_flight = 8;  // concurrent requests across all users
+    bool all_pages = false;    // follow pagination instead of stopping at the first page
+    size_t prefetch = 2;       // pages per user fetched ahead of the one being parsed
+    EventFilter filter;        // which events to hand on; older than `since` also stops the paging
+    ResponseCache* cache = nullptr;  // keeps parsed pages in binary form, read back instead of reparsing on a 304
+    Tracer* tracer = nullptr;  // records how long each page took to parse and hand on, if set
+    // per user, when their events were last read in full (epoch seconds, 0 for never); if set, the
+    // users read longest ago are requested first rather than in input order
+    std::vector<std::int64_t> last_read;
+};
+
+/**
+ * @brief Receives the fetched events, in input order.
+ *
+ * on_event returns whether it wants more of the user's events; returning false stops the user's
+ * paging, as if the event had been the last one. on_user_done is told whether all of the user's
+ * pages could be read and, if not, why; nothing else reports it.
+ */
+struct FetchCallbacks {
+    std::function<void(size_t user)> on_user_start;
+    std::function<bool(size_t user, const EventView& event)> on_event;
+    std::function<void(size_t user, bool ok, const std::string& error)> on_user_done;
+};
+
+/**
+ * @brief What the API's response headers said about how often it may be polled.
+ */
+struct ServerHints {
+    std::optional<long> poll_interval;                // X-Poll-Interval, the longest seen (seconds)
+    std::optional<long> rate_limit_remaining;         // X-RateLimit-Remaining, the lowest seen
+    std::optional<std::int64_t> rate_limit_reset;     // X-RateLimit-Reset (epoch seconds)
+};
+
+/**
+ * @brief Fetches the events of many users concurrently and hands them on in input order.
+ *
+ * Every page is parsed incrementally as it streams in. The page at the head of the output order is
+ * passed straight through; pages that arrive out of turn are held back until everything before them
+ * has been handed on. In paging mode, per_page=100 is requested and the Link header of the first page
+ * tells how many more pages there are; up to `prefetch` of them per user are fetched in parallel while
+ * the current one is being parsed.
+ *
+ * With a cache, each parsed page is also written out as a binary event cache tagged with the page's
+ * ETag. When the server later answers 304 for that page, its events are rendered straight from the
+ * memory-mapped binary cache instead of reparsing the cached JSON.
+ */
+class EventFetcher {
+public:
+    static constexpr size_t per_page = 100;
+    static constexpr size_t max_events = 300;  // the API won't page past this many events
+    static constexpr size_t max_pages = max_events / per_page;
+    static constexpr size_t default_per_page = 30;  // what the API sends without per_page
+    static constexpr size_t string_bytes_per_event = 64;  // rough average, to size a page's arena
+
+    EventFetcher(HttpClient& client, FetchOptions options);
+
+    void fetch(const std::vector<std::string>& usernames, FetchCallbacks callbacks);
+    const ServerHints& server_hints() const { return hints; }
+    size_t requests_made() const { return answered; }
+
+private:
+    struct PageFetch {
+        size_t number = 1;
+        std::unique_ptr<EventStreamParser> parser;
+        HttpRequest* request = nullptr;
+        bool done = false;
+
+        // events parsed while the page wasn't at the head, plus all of them when caching
+        EventStore events;
+        size_t handed_on = 0;  // events in the store that were already handed on
+        size_t shown = 0;      // events in the store that pass the filters
+
+        std::string etag;
+        std::unique_ptr<MappedEventCache> cached_events;  // the page's events, when served from the cache
+
+        // with a tracer: time spent parsing the page and handing its events on, from when each began
+        Tracer::Clock::time_point parse_start, render_start;
+        Tracer::Clock::duration parse_time{0}, render_time{0};
+        size_t bytes = 0;
+        size_t parsed = 0;
+        size_t rendered = 0;
+    };
+
+    struct UserFetch {
+        std::string username;
+        std::deque<PageFetch> pages;
+        size_t page_count = 1;  // pages that will be handed on (grows once the Link header is in)
+        size_t pages_done = 0;
+        int priority = 0;  // of the user's requests
+        bool started = false;
+        bool ok = true;
+        std::string error;     // what was wrong with the first page that couldn't be read
+        bool stopped = false;  // on_event didn't want any more
+    };
+
+    void queue_page(size_t user, size_t number);
+    void queue_more_pages(size_t user);
+    void handle_data(size_t user, size_t page, const char* data, size_t size);
+    void handle_event(size_t user, size_t page, const Event& event);
+    void handle_header(size_t user, size_t page, std::string_view name, std::string_view value);
+    bool handle_not_modified(size_t user, size_t page, const CachedResponse& cached);
+    void complete_page(size_t user, size_t page, const HttpResult& result);
+    void flush_page(size_t user, size_t page);
+    void hand_on(size_t user, size_t page, const EventView& event);
+    void trace_page(size_t user, size_t page, bool from_cache);
+    void cut_off(size_t user, size_t first_dropped);
+    std::string events_path(const PageFetch& page_fetch) const;
+    void advance();
+
+    HttpClient& client;
+    FetchOptions options;
+    FetchCallbacks callbacks;
+
+    std::deque<UserFetch> users;
+    std::deque<HttpRequest> requests;
+    size_t answered = 0;  // requests of the last fetch the API answered (retries aside)
+    size_t head_user = 0;
+    size_t head_page = 0;
+    ServerHints hints;
+};
+
+size_t last_page_from_link_header(std::string_view link);
+
+#endif  // FETCHING_HPP
@@ -0,0 +1,49 @@
+#ifndef FILTER_HPP
+#define FILTER_HPP
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "event.hpp"
+
+/**
+ * @brief Which events to show, compiled from --type, --repo, --action, --since and --until.
+ *
+ * Types and actions are compiled into bitmasks over the interned enums, so checking them is a bit
+ * test. The parser checks the type, repository and action as soon as it reads each of them, and an
+ * event that's rejected skips the rest of its payload and is never handed on. `created_at` comes
+ * after the payload in Github's JSON, so the time window is checked on the parsed events instead.
+ */
+class EventFilter {
+public:
+    void add_type(std::string_view name);
+    void add_repo(std::string_view glob);
+    void add_action(std::string_view name);
+
+    std::optional<std::int64_t> since;  // epoch cutoff; older events (and the pages after them) are skipped
+    std::optional<std::int64_t> until;  // epoch cutoff; newer events are skipped
+
+    bool filters_content() const;
+    std::string content_key() const;
+
+    bool accepts_type(EventType type) const;
+    bool accepts_repo(std::string_view repo) const;
+    bool accepts_action(EventAction action, std::string_view name) const;
+    bool accepts_time(std::int64_t time) const;
+    bool accepts(const EventView& event) const;
+
+private:
+    std::uint32_t types = 0;    // bit per EventType; 0 accepts any
+    std::uint32_t actions = 0;  // bit per EventAction; 0 with no action_names accepts any
+    std::vector<std::string> action_names;  // actions that aren't interned
+    std::vector<std::string> repo_globs;
+
+    static_assert((size_t)EventType::Count <= 32 && (size_t)EventAction::Count <= 32);
+};
+
+bool glob_match(std::string_view pattern, std::string_view text);
+
+#endif  // FILTER_HPP
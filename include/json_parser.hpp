@@ -0,0 +1,47 @@
+#ifndef JSON_PARSER_HPP
+#define JSON_PARSER_HPP
+
+#include <cstddef>
+#include <map>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <lib/json.hpp>
+
+std::pmr::memory_resource& parse_scratch();
+void set_parse_scratch_enabled(bool enabled);
+
+/**
+ * @brief Allocates from the calling thread's parse scratch arena.
+ *
+ * The arena is reset whenever sax_parse_json returns, so anything allocated with this only lives
+ * until then. It carries no state, which lets the parser default-construct its buffers with it.
+ */
+template <typename T>
+struct ScratchAllocator {
+    using value_type = T;
+
+    ScratchAllocator() noexcept = default;
+    template <typename U>
+    ScratchAllocator(const ScratchAllocator<U>&) noexcept {}
+
+    T* allocate(std::size_t count) {
+        return static_cast<T*>(parse_scratch().allocate(count * sizeof(T), alignof(T)));
+    }
+    void deallocate(T* pointer, std::size_t count) noexcept {
+        parse_scratch().deallocate(pointer, count * sizeof(T), alignof(T));
+    }
+
+    friend bool operator==(const ScratchAllocator&, const ScratchAllocator&) { return true; }
+};
+
+// the strings the parser reads into and hands to SAX handlers; copy out of them what's to be kept
+using ScratchString = std::basic_string<char, std::char_traits<char>, ScratchAllocator<char>>;
+// only ever used through SAX handlers, so no DOM is ever built from it
+using ScratchJson = nlohmann::basic_json<std::map, std::vector, ScratchString>;
+
+bool sax_parse_json(std::string_view document, nlohmann::json_sax<ScratchJson>& handler);
+
+#endif  // JSON_PARSER_HPP
@@ -0,0 +1,91 @@
+#ifndef OUTPUT_HPP
+#define OUTPUT_HPP
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include <sys/uio.h>
+
+#include "event.hpp"
+
+/*
+ * Binary output format (`--format=bin`), little-endian throughout:
+ *
+ *   "GHEVSTRM" (8 bytes), u32 version
+ *   then for every event:
+ *     u32 length   of the rest of the record, so a reader can skip records it doesn't want
+ *     u64 id
+ *     i64 created_at   seconds since the Unix epoch
+ *     u8  type         EventType value (0 is Unknown, see the type string)
+ *     u8  action       EventAction value (0 is None, 1 is Unknown, see the action string)
+ *     u16 present      which optional fields the event has, as PackedEvent's field flags
+ *     i32 issue_number, pr_number, commit_count   0 when absent
+ *     string user, type, action, repo, assignee, label, collaborator, pr_title, requested_reviewers
+ *
+ * Every string is a u32 byte count followed by the UTF-8 bytes, empty when absent;
+ * requested_reviewers are separated by commas. The version changes whenever the layout or the
+ * enum values do.
+ */
+static constexpr char BINARY_STREAM_MAGIC[8] = {'G', 'H', 'E', 'V', 'S', 'T', 'R', 'M'};
+static constexpr std::uint32_t BINARY_STREAM_VERSION = 1;
+
+/**
+ * @brief What the events are written as.
+ */
+enum class OutputFormat {
+    Text,    // a sentence per event, under a header per user
+    Ndjson,  // a JSON object per line
+    Csv,     // a header row, then a row per event
+    Binary   // length-prefixed records, see above
+};
+
+std::optional<OutputFormat> output_format_from_string(std::string_view name);
+void append_stream_header(std::string& out, OutputFormat format);
+void append_event_record(std::string& out, OutputFormat format, const EventView& event, std::string_view user,
+                         bool show_times, std::int64_t now);
+void append_event_line(std::string& out, const EventView& event, bool show_times, std::int64_t now);
+void append_json_string(std::string& out, std::string_view str);
+
+/**
+ * @brief Buffered writer for the program's output.
+ *
+ * Lines are formatted straight into one reusable buffer, which goes out with a single write(2) once
+ * it fills up or a batch (a user, a page, a poll) is done, instead of a syscall per line. A block
+ * that's already rendered, such as a page from the pipeline, goes out together with whatever is
+ * buffered in front of it in one writev(2), without being copied. Line-buffered mode writes after
+ * every line instead, for tailing the output as it happens.
+ */
+class OutputWriter {
+public:
+    static constexpr size_t default_capacity = 64 * 1024;  // bytes buffered before they're written regardless
+
+    explicit OutputWriter(int fd, bool line_buffered = false, size_t capacity = default_capacity);
+    ~OutputWriter();
+
+    OutputWriter(const OutputWriter&) = delete;
+    OutputWriter& operator=(const OutputWriter&) = delete;
+
+    std::string& buffer() { return pending; }
+    void end_line();
+    void write(std::string_view block);
+    bool flush();
+
+    bool line_buffered() const { return line_mode; }
+    size_t bytes_written() const { return written; }
+    size_t syscalls() const { return calls; }
+
+private:
+    bool write_all(struct iovec* parts, int count);
+
+    int fd;
+    bool line_mode;
+    size_t capacity;
+    std::string pending;  // formatted but not written yet
+    size_t written = 0;
+    size_t calls = 0;
+    bool failed = false;  // a write failed (e.g. the pipe was closed), so output is dropped from then on
+};
+
+#endif  // OUTPUT_HPP
@@ -1,11 +1,61 @@
 #ifndef PARSING_HPP
 #define PARSING_HPP
 
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
 #include "event.hpp"
+#include "filter.hpp"
+
+// the event is only valid for the duration of the call
+using EventCallback = std::function<void(const Event&)>;
+
+class EventSaxHandler;
 
 std::vector<Event> parse_json_response(const std::string& response);
+bool parse_json_response(const std::string& response, const EventCallback& on_event, std::string* error = nullptr,
+                         const EventFilter* filter = nullptr);
+
+/**
+ * @brief Incrementally parses a Github events response as it arrives.
+ *
+ * The body can be fed in arbitrary chunks, e.g. straight from a libcurl write callback. The event
+ * objects in the top-level array that a chunk completes are handed to the callback as soon as the
+ * chunk is fed, so parsing overlaps with the transfer instead of waiting for the whole body. They
+ * are parsed in one batch per chunk rather than one at a time, since every run of the JSON parser
+ * starts with empty buffers.
+ */
+class EventStreamParser {
+public:
+    explicit EventStreamParser(EventCallback on_event, const EventFilter* filter = nullptr);
+    ~EventStreamParser();
+
+    void feed(const char* data, std::size_t size);
+    bool finish(std::string* error = nullptr);
+    std::optional<std::int64_t> oldest_time() const;
+
+private:
+    enum class State { BeforeDocument, InArray, InErrorObject, Done, Failed };
+    // what the top-level array may go on with, between its elements
+    enum class Expected { ElementOrEnd, SeparatorOrEnd, Element };
+
+    bool between_elements() const;
+    void parse_element();
+    void parse_batch();
+
+    std::unique_ptr<EventSaxHandler> handler;
+    std::string buffer;  // bytes of the element currently being received
+    std::string batch;   // the events the current chunk completed, as a JSON array
+    State state = State::BeforeDocument;
+    Expected expected = Expected::ElementOrEnd;
+    int depth = 0;
+    bool in_string = false;
+    bool pending_escape = false;
+};
 
 #endif  // PARSING_HPP
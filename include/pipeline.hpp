@@ -0,0 +1,138 @@
+#ifndef PIPELINE_HPP
+#define PIPELINE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "fetching.hpp"
+#include "filter.hpp"
+#include "output.hpp"
+#include "queue.hpp"
+#include "requests.hpp"
+#include "stats.hpp"
+#include "trace.hpp"
+
+/**
+ * @brief Settings for a RenderPipeline.
+ */
+struct PipelineOptions {
+    size_t workers = 4;          // threads that parse and format pages
+    size_t queue_capacity = 64;  // pages each queue holds before its producer has to wait
+    EventFilter filter;          // which events to show; older than `since` also ends the user's pages
+    OutputFormat format = OutputFormat::Text;
+    bool show_times = false;     // follow each event with how long ago it happened
+    std::int64_t now = 0;        // the time show_times is relative to
+    bool stats = false;          // count the events into ActivityStats instead of rendering them
+    Tracer* tracer = nullptr;    // records how long each page took to parse and render, if set
+};
+
+/**
+ * @brief A response body waiting to be parsed.
+ */
+struct PageJob {
+    size_t user = 0;
+    size_t page = 0;        // index of the page within the user's pages
+    size_t page_count = 1;  // how many pages the user has
+    bool ok = false;        // whether the transfer completed
+    std::string error;      // why it didn't, if it didn't
+    std::string body;
+};
+
+/**
+ * @brief A page's events, rendered as lines of output and waiting to be written.
+ */
+struct RenderedPage {
+    size_t user = 0;
+    size_t page = 0;
+    size_t page_count = 1;
+    bool ok = false;    // whether the page was fetched and parsed
+    bool last = false;  // whether the --since cutoff made this the user's last wanted page
+    size_t events = 0;
+    std::string text;
+    std::string error;  // what the API or the parser said was wrong, if anything
+};
+
+/**
+ * @brief How long each stage was busy, and how full the queues between them were.
+ */
+struct PipelineStats {
+    size_t pages = 0;
+    size_t events = 0;
+    size_t bytes_in = 0;   // response bytes parsed
+    size_t bytes_out = 0;  // output bytes written
+    size_t workers = 0;
+    size_t failed_users = 0;  // users whose events couldn't all be read
+
+    std::chrono::nanoseconds wall{0};
+    std::chrono::nanoseconds read{0};    // producing pages, less the time spent waiting for room in the queue
+    std::chrono::nanoseconds stalled{0}; // the producer waiting for room in the queue
+    std::chrono::nanoseconds parse{0};   // summed over the workers
+    std::chrono::nanoseconds format{0};  // summed over the workers
+    std::chrono::nanoseconds write{0};
+
+    // queue lengths, sampled whenever an item is taken off
+    size_t input_samples = 0, input_total = 0, input_max = 0, input_capacity = 0;
+    size_t output_samples = 0, output_total = 0, output_max = 0, output_capacity = 0;
+
+    void merge(const PipelineStats& other);
+};
+
+/**
+ * @brief Parses, formats and writes fetched pages on separate threads.
+ *
+ * Whoever produces the pages (the network thread, or a replay of recorded responses) submits them
+ * to a bounded lock-free queue. A pool of workers takes pages off it, parses each into a reused
+ * EventStore, renders the events that pass the filter as lines of output and puts the
+ * text on a second queue. A single writer thread takes the rendered pages off that one and writes
+ * them to an OutputWriter in input order, holding back any that are finished out of turn, so the producer only ever
+ * blocks when the workers fall a whole queue behind.
+ */
+class RenderPipeline {
+public:
+    RenderPipeline(std::vector<std::string> usernames, PipelineOptions options, OutputWriter& out);
+    ~RenderPipeline();
+
+    RenderPipeline(const RenderPipeline&) = delete;
+    RenderPipeline& operator=(const RenderPipeline&) = delete;
+
+    void submit(PageJob job);
+    PipelineStats finish();
+    ActivityStats activity() const;
+
+private:
+    void work(PipelineStats& stats, ActivityStats& activity);
+    void render(PageJob& job, RenderedPage& rendered, EventStore& events, PipelineStats& stats,
+                ActivityStats& activity) const;
+    void write();
+
+    std::vector<std::string> usernames;
+    PipelineOptions options;
+    OutputWriter& out;  // only used by the writer thread until the pipeline is finished
+    bool print_headers;
+
+    BoundedQueue<PageJob> input;
+    BoundedQueue<RenderedPage> output;
+    std::atomic<bool> input_closed{false};
+    std::atomic<size_t> workers_running{0};
+
+    std::vector<std::thread> workers;
+    std::vector<PipelineStats> worker_stats;
+    std::vector<ActivityStats> worker_activity;  // each worker's counts, with options.stats
+    std::thread writer;
+    PipelineStats writer_stats;
+    PipelineStats stats;  // the producer's side, so submit must always be called from the same thread
+    std::chrono::steady_clock::time_point started;
+    bool finished = false;
+};
+
+void fetch_into_pipeline(HttpClient& client, const FetchOptions& options, const std::vector<std::string>& usernames,
+                         RenderPipeline& pipeline);
+void print_pipeline_stats(const PipelineStats& stats);
+
+#endif  // PIPELINE_HPP
@@ -0,0 +1,140 @@
+#ifndef QUEUE_HPP
+#define QUEUE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <utility>
+
+/**
+ * @brief Bounded lock-free multi-producer/multi-consumer queue.
+ *
+ * A ring of slots with a sequence number each (Vyukov's design): producers and consumers claim a
+ * position with one compare-and-swap on their own counter and then only touch that slot, so
+ * neither side ever takes a lock or waits on the other unless the queue is full or empty. The
+ * capacity is rounded up to a power of two.
+ */
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t min_capacity) {
+        while (capacity < min_capacity) capacity *= 2;
+        slots = std::make_unique<Slot[]>(capacity);
+        for (size_t i = 0; i < capacity; ++i) {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    /**
+     * @brief Adds an item, unless the queue is full.
+     *
+     * @return  Whether the item was added (it's only moved from if so).
+     */
+    bool try_push(T& item) {
+        size_t position = tail.load(std::memory_order_relaxed);
+        while (true) {
+            Slot& slot = slots[position & (capacity - 1)];
+            const size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            const std::ptrdiff_t difference = (std::ptrdiff_t)sequence - (std::ptrdiff_t)position;
+
+            if (difference == 0) {
+                if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    slot.value = std::move(item);
+                    slot.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (difference < 0) {
+                return false;
+            } else {
+                position = tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * @brief Takes the oldest item, unless the queue is empty.
+     *
+     * @return  Whether an item was taken.
+     */
+    bool try_pop(T& item) {
+        size_t position = head.load(std::memory_order_relaxed);
+        while (true) {
+            Slot& slot = slots[position & (capacity - 1)];
+            const size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            const std::ptrdiff_t difference = (std::ptrdiff_t)sequence - (std::ptrdiff_t)(position + 1);
+
+            if (difference == 0) {
+                if (head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    item = std::move(slot.value);
+                    slot.sequence.store(position + capacity, std::memory_order_release);
+                    return true;
+                }
+            } else if (difference < 0) {
+                return false;
+            } else {
+                position = head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * @brief Returns roughly how many items are queued (exact only when nothing is being pushed or popped).
+     */
+    size_t size() const {
+        const size_t pushed = tail.load(std::memory_order_relaxed);
+        const size_t popped = head.load(std::memory_order_relaxed);
+        return (pushed > popped) ? pushed - popped : 0;
+    }
+
+    size_t max_size() const { return capacity; }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    // keeps the producers' and the consumers' counters from sharing a cache line
+    static constexpr size_t cache_line = 64;
+
+    size_t capacity = 2;
+    std::unique_ptr<Slot[]> slots;
+    alignas(cache_line) std::atomic<size_t> tail{0};
+    alignas(cache_line) std::atomic<size_t> head{0};
+};
+
+/**
+ * @brief Waits for a queue to have room or items: spins briefly, then yields, then sleeps for
+ *        increasingly long, so an idle stage doesn't burn a core.
+ */
+class Backoff {
+public:
+    void wait() {
+        if (rounds < 64) {
+            // spin
+        } else if (rounds < 128) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(sleep);
+            sleep = std::min(sleep * 2, std::chrono::microseconds(1000));
+        }
+        ++rounds;
+    }
+
+    void reset() {
+        rounds = 0;
+        sleep = std::chrono::microseconds(20);
+    }
+
+private:
+    unsigned rounds = 0;
+    std::chrono::microseconds sleep{20};
+};
+
+#endif  // QUEUE_HPP
@@ -0,0 +1,49 @@
+#ifndef RATE_LIMITER_HPP
+#define RATE_LIMITER_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <random>
+
+/**
+ * @brief Paces requests so they stay within the API's rate limit instead of running into it.
+ *
+ * A token bucket: every request takes a token, and tokens are refilled at the rate the remaining
+ * quota allows until it resets (X-RateLimit-Remaining / X-RateLimit-Reset). Past a burst of up to
+ * `burst` requests, they are spread over the window rather than spending the quota at once and
+ * stalling until it resets. Until the first response says what the quota is, requests aren't held
+ * back.
+ *
+ * When the API answers with a rate-limit error anyway (403 with no quota left or a Retry-After,
+ * or 429 for its secondary limits), every request is paused for a jittered, exponentially growing
+ * backoff, or for as long as the response asks.
+ */
+class RateLimiter {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr int max_retries = 3;  // per request, for rate-limit errors
+    static constexpr double burst = 100;   // most tokens the bucket holds
+
+    RateLimiter();
+
+    bool try_acquire(Clock::time_point now);
+    Clock::duration time_until_token(Clock::time_point now) const;
+    void update(std::int64_t remaining, std::int64_t reset);
+    Clock::duration back_off(int attempt, std::optional<std::int64_t> retry_after);
+
+private:
+    void refill(Clock::time_point now);
+
+    bool limited = false;  // whether the quota is known yet
+    double tokens = burst;
+    double capacity = burst;
+    double rate = 0;       // tokens per second
+    Clock::time_point last_refill;
+    Clock::time_point window_reset;  // when the quota starts over
+    Clock::time_point paused_until;
+    std::minstd_rand rng;
+};
+
+#endif  // RATE_LIMITER_HPP
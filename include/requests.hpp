@@ -2,7 +2,106 @@
 #define REQUESTS_HPP
 
 #include <cstdlib>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <vector>
+
+#include <curl/curl.h>
+
+#include "cache.hpp"
+#include "rate_limiter.hpp"
+#include "trace.hpp"
+
+/**
+ * @brief Outcome of a finished transfer.
+ */
+struct HttpResult {
+    bool ok = false;  // whether the transfer itself completed
+    long status = 0;  // HTTP status code of the response
+    bool from_cache = false;  // the server answered 304 and the cached body was replayed
+    std::string error;        // why the transfer didn't complete, if it didn't
+};
+
+using DataCallback = std::function<void(const char* data, size_t size)>;
+using HeaderCallback = std::function<void(std::string_view name, std::string_view value)>;
+using CompletionCallback = std::function<void(const HttpResult& result)>;
+using NotModifiedCallback = std::function<bool(const CachedResponse& cached)>;
+
+/**
+ * @brief A GET request for HttpClient to run.
+ */
+struct HttpRequest {
+    std::string endpoint;
+    DataCallback on_data;            // called with each chunk of the response body
+    CompletionCallback on_complete;  // called once the transfer has finished (or failed)
+    HeaderCallback on_header;        // optional, called with each response header (name in lowercase)
+    NotModifiedCallback on_not_modified;  // optional, return true on a 304 to skip replaying the cached body
+    bool cancelled = false;          // set to skip the request, or abort it if it's already running
+    int priority = 0;                // get_all starts queued requests with a higher priority first
+};
+
+/**
+ * @brief Settings shared by every request an HttpClient makes.
+ */
+struct HttpClientOptions {
+    bool reuse_connections = true;  // share DNS, TLS sessions and connections between requests
+    bool compression = true;        // accept every encoding libcurl can decode (gzip, deflate, zstd, brotli)
+    bool http2 = true;              // negotiate HTTP/2 over TLS and multiplex concurrent requests to a host
+    std::string ca_file;            // CA bundle to verify peers with (libcurl's default if empty)
+    ResponseCache* cache = nullptr; // makes requests conditional on the cached response, if set
+    RateLimiter* rate_limiter = nullptr;  // paces requests and retries rate-limit errors, if set
+    Tracer* tracer = nullptr;       // records every transfer's timings, if set
+};
+
+/**
+ * @brief Reusable HTTP client for the Github API.
+ *
+ * Owns a pool of configured easy handles and a CURLSH share for the DNS cache, TLS sessions and
+ * connections, so repeated requests (paging, multiple users) skip the DNS lookup and TCP/TLS
+ * handshakes once a connection to the host is warm. Over HTTP/2, all of get_all's concurrent
+ * requests to a host are multiplexed as streams over a single connection: requests started before
+ * the first connection has finished its handshake wait for it instead of opening connections of
+ * their own.
+ */
+class HttpClient {
+public:
+    explicit HttpClient(HttpClientOptions options = HttpClientOptions());
+    ~HttpClient();
+
+    HttpClient(const HttpClient&) = delete;
+    HttpClient& operator=(const HttpClient&) = delete;
+
+    bool get(const std::string& endpoint, DataCallback on_data);
+    HttpResult get(HttpRequest& request);
+    void get_all(std::deque<HttpRequest>& requests, size_t max_in_flight);
+
+private:
+    struct Transfer;
+
+    CURL* acquire_handle();
+    void release_handle(CURL* curl);
+    Transfer* prepare_handle(CURL* curl, HttpRequest& request, int attempt = 0);
+    HttpResult finish_handle(CURL* curl, CURLcode response);
+    std::optional<RateLimiter::Clock::duration> check_rate_limit(CURL* curl, CURLcode response);
+    void trace_transfer(CURL* curl, CURLcode response);
+
+    static size_t write_callback(void* contents, size_t size, size_t nmemb, void* userp);
+    static size_t header_callback(char* buffer, size_t size, size_t nitems, void* userp);
+    static void lock_share(CURL* handle, curl_lock_data data, curl_lock_access access, void* userp);
+    static void unlock_share(CURL* handle, curl_lock_data data, void* userp);
+
+    HttpClientOptions options;
+    CURLSH* share = nullptr;
+    CURLM* multi = nullptr;
+    struct curl_slist* headers = nullptr;
+    std::vector<CURL*> idle_handles;
+    std::mutex pool_mutex;
+    std::mutex share_mutexes[CURL_LOCK_DATA_LAST];
+};
 
 /**
  * @brief Builds and sends a GET request to the given API endpoint and returns JSON response data.
@@ -12,4 +111,13 @@
  */
 std::string get_json_response(const std::string& endpoint);
 
+/**
+ * @brief Builds and sends a GET request to the given API endpoint, passing the response body on as it arrives.
+ *
+ * @param endpoint  The API endpoint to make a request to.
+ * @param on_data   Called with each chunk of the response body as soon as libcurl receives it.
+ * @return          Whether the transfer completed.
+ */
+bool stream_json_response(const std::string& endpoint, DataCallback on_data);
+
 #endif  // REQUESTS_HPP
@@ -0,0 +1,57 @@
+#ifndef STATS_HPP
+#define STATS_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "event.hpp"
+#include "event_store.hpp"
+
+/**
+ * @brief Counts of events by type, repository, action and hour of the day, for `--stats`.
+ *
+ * Built in a single pass straight off the parsed events, without rendering any of them. Types and
+ * actions are already interned, so they're counted in plain arrays. Repositories are counted in a
+ * flat open-addressing hash table whose names are interned into one string arena, so a repository
+ * costs one copy of its name however many events it has. Each thread keeps its own counts and they
+ * are merged at the end.
+ */
+class ActivityStats {
+public:
+    void add(const EventView& event);
+    void merge(const ActivityStats& other);
+    void append_report(std::string& out) const;
+
+    std::uint64_t events() const { return event_count; }
+
+private:
+    struct RepoSlot {
+        std::uint64_t hash = 0;
+        std::uint64_t count = 0;  // 0 marks an empty slot
+        StringRef name = {0, 0};
+    };
+
+    void count_repo(std::string_view name, std::uint64_t hash, std::uint64_t count);
+    void grow_repos();
+
+    std::uint64_t event_count = 0;
+    std::uint64_t commit_count = 0;  // commits pushed
+    std::array<std::uint64_t, (size_t)EventType::Count> types{};
+    std::array<std::uint64_t, (size_t)EventAction::Count> actions{};
+    std::array<std::uint64_t, 24> hours{};  // UTC
+    // types and actions not in the enums, which are rare
+    std::map<std::string, std::uint64_t, std::less<>> unknown_types;
+    std::map<std::string, std::uint64_t, std::less<>> unknown_actions;
+
+    std::vector<RepoSlot> repo_slots;  // a power of two of them, at most half full
+    size_t repo_count = 0;
+    std::string repo_names;
+};
+
+#endif  // STATS_HPP
@@ -0,0 +1,12 @@
+#ifndef TIMESTAMP_HPP
+#define TIMESTAMP_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+bool parse_timestamp(std::string_view text, std::int64_t& seconds);
+void append_timestamp(std::string& out, std::int64_t seconds);
+void append_relative_time(std::string& out, std::int64_t seconds_ago);
+
+#endif  // TIMESTAMP_HPP
@@ -0,0 +1,76 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <initializer_list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief What `--trace` writes its records as.
+ */
+enum class TraceFormat {
+    Jsonl,  // a JSON object per line
+    Chrome  // the Trace Event Format that chrome://tracing and Perfetto load
+};
+
+std::optional<TraceFormat> trace_format_from_string(std::string_view name);
+
+/**
+ * @brief A named number or string attached to a trace record.
+ */
+struct TraceArg {
+    TraceArg(std::string_view name, std::int64_t number) : name(name), number(number) {}
+    TraceArg(std::string_view name, std::string_view text) : name(name), text(text), is_text(true) {}
+
+    std::string_view name;
+    std::int64_t number = 0;
+    std::string_view text;
+    bool is_text = false;
+};
+
+/**
+ * @brief Records how long each request, parse and render took, for `--trace`.
+ *
+ * Whatever is traced holds a Tracer pointer that is null when tracing is off, so the only cost then is
+ * that one test per request or page. Records are written as they're made, from any thread; timestamps
+ * are microseconds since the tracer was created.
+ *
+ * In the Chrome format, spans that run one after another on a thread (a pipeline worker's pages) go on
+ * that thread's track. Spans that overlap others on the same thread (concurrent transfers, pages that
+ * are parsed as they stream in) are async spans, which the viewers lay out on separate rows.
+ */
+class Tracer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    Tracer(const std::string& path, TraceFormat format);
+    ~Tracer();
+
+    Tracer(const Tracer&) = delete;
+    Tracer& operator=(const Tracer&) = delete;
+
+    void span(std::string_view name, Clock::time_point start, Clock::duration duration,
+              std::initializer_list<TraceArg> args);
+    void async_span(std::string_view name, Clock::time_point start, Clock::duration duration,
+                    std::initializer_list<TraceArg> args);
+    void flush();
+
+private:
+    void record(std::string_view name, Clock::time_point start, Clock::duration duration,
+                std::initializer_list<TraceArg> args, bool async);
+
+    TraceFormat format;
+    std::ofstream file;
+    std::mutex file_mutex;
+    bool first = true;  // no record has been written yet
+    Clock::time_point started;
+    std::atomic<std::uint64_t> next_async_id{1};
+};
+
+#endif  // TRACE_HPP
@@ -0,0 +1,43 @@
+#include <algorithm>
+#include <bit>
+
+#include "arena.hpp"
+
+/**
+ * @param capacity  Bytes to reserve up front; the buffer grows past this as needed, up to max_capacity.
+ */
+ScratchArena::ScratchArena(size_t capacity)
+    : buffer(std::make_unique_for_overwrite<std::byte[]>(capacity)), buffer_size(capacity) {
+    arena.emplace(buffer.get(), buffer_size, &overflow);
+}
+
+/**
+ * @brief Frees everything allocated from the arena since the last reset.
+ *
+ * Nothing allocated from it may be used afterwards.
+ */
+void ScratchArena::reset() {
+    if (overflow.bytes == 0 || buffer_size >= max_capacity) {
+        // nothing spilled, or the buffer is as big as it gets: this only rewinds the arena to the start
+        // of its buffer, handing whatever spilled back to the heap
+        arena->release();
+        overflow.bytes = 0;
+        return;
+    }
+
+    // the round didn't fit: drop the spilled blocks, and start the next one with room for all of it
+    arena.reset();
+    buffer_size = std::min(std::bit_ceil(buffer_size + overflow.bytes), max_capacity);
+    overflow.bytes = 0;
+    buffer = std::make_unique_for_overwrite<std::byte[]>(buffer_size);
+    arena.emplace(buffer.get(), buffer_size, &overflow);
+}
+
+void* ScratchArena::Overflow::do_allocate(size_t bytes, size_t alignment) {
+    this->bytes += bytes;
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+}
+
+void ScratchArena::Overflow::do_deallocate(void* pointer, size_t bytes, size_t alignment) {
+    std::pmr::new_delete_resource()->deallocate(pointer, bytes, alignment);
+}
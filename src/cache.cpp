@@ -0,0 +1,116 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <iostream>
+
+#include <unistd.h>
+
+#include "cache.hpp"
+
+// first line of every cache file, bumped whenever the layout changes
+static const char* const CACHE_MAGIC = "github-activity response cache v1";
+
+ResponseCache::ResponseCache(std::string directory) : directory(std::move(directory)) {}
+
+/**
+ * @brief Returns the cache directory to use when none is given: $XDG_CACHE_HOME/github-activity,
+ *        falling back to ~/.cache/github-activity.
+ */
+std::string ResponseCache::default_directory() {
+    if (const char* xdg_cache = std::getenv("XDG_CACHE_HOME"); xdg_cache && *xdg_cache) {
+        return std::string(xdg_cache) + "/github-activity";
+    }
+    if (const char* home = std::getenv("HOME"); home && *home) {
+        return std::string(home) + "/.cache/github-activity";
+    }
+    return ".github-activity-cache";
+}
+
+/**
+ * @brief Looks up the cached response for an endpoint.
+ *
+ * @param endpoint   The full request URL.
+ * @param with_body  Whether to read the body too, or just the validators.
+ * @return           The cached response, or nothing if there isn't a (readable) one.
+ */
+std::optional<CachedResponse> ResponseCache::load(const std::string& endpoint, bool with_body) const {
+    std::ifstream file(path_for(endpoint, ".http"), std::ios::binary);
+    if (!file) {
+        return std::nullopt;
+    }
+
+    std::string magic, url;
+    CachedResponse response;
+    if (!std::getline(file, magic) || magic != CACHE_MAGIC ||
+        !std::getline(file, url) || url != endpoint ||
+        !std::getline(file, response.etag) ||
+        !std::getline(file, response.last_modified) ||
+        !std::getline(file, response.link)) {
+        return std::nullopt;
+    }
+
+    if (with_body) {
+        response.body.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+    return response;
+}
+
+/**
+ * @brief Stores the response for an endpoint, replacing any previous one.
+ *
+ * The file is written under a temporary name and renamed into place, so concurrent runs never see
+ * a half-written entry. Failures are reported but not fatal; the cache is only an optimization.
+ *
+ * @param endpoint  The full request URL.
+ * @param response  The response to cache.
+ */
+void ResponseCache::store(const std::string& endpoint, const CachedResponse& response) const {
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+
+    const std::string path = path_for(endpoint, ".http");
+    const std::string temp_path = path + ".tmp" + std::to_string(getpid());
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            std::cerr << "Warning: couldn't write to cache directory " << directory << std::endl;
+            return;
+        }
+
+        file << CACHE_MAGIC << '\n'
+             << endpoint << '\n'
+             << response.etag << '\n'
+             << response.last_modified << '\n'
+             << response.link << '\n'
+             << response.body;
+    }
+
+    std::filesystem::rename(temp_path, path, error);
+    if (error) {
+        std::filesystem::remove(temp_path, error);
+    }
+}
+
+/**
+ * @brief Returns where the parsed events of an endpoint's cached response are kept (see event_cache.hpp).
+ */
+std::string ResponseCache::events_path(const std::string& endpoint) const {
+    return path_for(endpoint, ".events");
+}
+
+/**
+ * @brief Maps an endpoint to its cache file, named after the FNV-1a hash of the URL.
+ */
+std::string ResponseCache::path_for(const std::string& endpoint, const char* extension) const {
+    std::uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : endpoint) {
+        hash = (hash ^ c) * 1099511628211ull;
+    }
+
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx%s", (unsigned long long)hash, extension);
+    return directory + "/" + name;
+}
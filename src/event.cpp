@@ -1,211 +1,471 @@
-#include <functional>
-#include <unordered_map>
-#include <cstring>
+#include <algorithm>
+#include <charconv>
 
 #include "event.hpp"
 
+namespace {
+
+// raw names, indexed by EventType
+constexpr std::string_view event_type_names[] = {
+    "",
+    "CommitCommentEvent",
+    "CreateEvent",
+    "DeleteEvent",
+    "ForkEvent",
+    "GollumEvent",
+    "IssueCommentEvent",
+    "IssuesEvent",
+    "MemberEvent",
+    "PublicEvent",
+    "PullRequestEvent",
+    "PullRequestReviewEvent",
+    "PullRequestReviewCommentEvent",
+    "PullRequestReviewThreadEvent",
+    "PushEvent",
+    "ReleaseEvent",
+    "SponsorshipEvent",
+    "WatchEvent"
+};
+static_assert(std::size(event_type_names) == (size_t)EventType::Count);
+
+// raw names, indexed by EventAction
+constexpr std::string_view event_action_names[] = {
+    "",
+    "",
+    "added",
+    "assigned",
+    "closed",
+    "created",
+    "deleted",
+    "edited",
+    "labeled",
+    "opened",
+    "published",
+    "reopened",
+    "resolved",
+    "review_request_removed",
+    "review_requested",
+    "started",
+    "synchronize",
+    "unassigned",
+    "unlabeled",
+    "unresolved"
+};
+static_assert(std::size(event_action_names) == (size_t)EventAction::Count);
+
+}  // namespace
+
+/**
+ * @brief Interns an event type string.
+ *
+ * @param type  The event's `type`, e.g. "PushEvent".
+ * @return      The matching EventType, or Unknown.
+ */
+EventType event_type_from_string(std::string_view type) {
+    for (size_t i = 1; i < std::size(event_type_names); ++i) {
+        if (event_type_names[i] == type) return (EventType)i;
+    }
+    return EventType::Unknown;
+}
+
+/**
+ * @brief Interns a payload action string.
+ *
+ * @param action  The payload's `action`, e.g. "opened".
+ * @return        The matching EventAction, or Unknown.
+ */
+EventAction event_action_from_string(std::string_view action) {
+    for (size_t i = 2; i < std::size(event_action_names); ++i) {
+        if (event_action_names[i] == action) return (EventAction)i;
+    }
+    return EventAction::Unknown;
+}
+
+/**
+ * @brief Returns the Github name of an event type (empty for Unknown).
+ */
+std::string_view to_string(EventType type) {
+    return event_type_names[(size_t)type];
+}
+
+/**
+ * @brief Returns the Github name of an action (empty for None and Unknown).
+ */
+std::string_view to_string(EventAction action) {
+    return event_action_names[(size_t)action];
+}
+
 /**
 * @brief Returns a human-readable string representation of the Event.
 *
 * @return  A string containing event information.
 */
 std::string Event::to_str() const {
-    const char* type_c_str = type.c_str();
-    // NOTE: action_phrase should NEVER end with whitespace, EVER
-    std::string action_phrase;
-
-    std::function<std::string()> handle_issue_comment_event = [&]() -> std::string {
-        std::string action_phrase;
-        const std::string suffix = "a comment on issue #" + std::to_string(issue_number.value()) + " in";
-
-        std::unordered_map<std::string, std::function<std::string()>> action_verb_map = {
-            {"created", [&]() { return "Left " + suffix; }},
-            {"edited", [&]() { return "Edited " + suffix; }},
-            {"deleted", [&]() { return "Deleted " + suffix; }}
-        };
-
-        if (action_verb_map.find(*action) != action_verb_map.end()) {
-            action_phrase = action_verb_map[*action]();
-        }
+    std::string reviewer_buffer;
+    return view(reviewer_buffer).to_str();
+}
 
-        return action_phrase;
+/**
+ * @brief Returns a non-owning view of the Event's fields.
+ *
+ * @param reviewer_buffer  Storage for the joined requested reviewers, which must outlive the view.
+ * @return                 A view of this Event.
+ */
+EventView Event::view(std::string& reviewer_buffer) const {
+    EventView event_view = {
+        id,
+        type,
+        type_name,
+        time,
+        repo_name,
+        issue_number,
+        pr_number,
+        commit_count,
+        action,
+        action_name,
+        assignee,
+        label,
+        collaborator,
+        pr_title,
+        std::nullopt
     };
 
-    std::function<std::string()> handle_issue_event = [&]() -> std::string {
-        std::string action_phrase;
-        const std::string suffix = "issue #" + std::to_string(issue_number.value()) + " in";
-
-        std::unordered_map<std::string, std::function<std::string()>> action_verb_map = {
-            {"opened", [&]() { return "Opened " + suffix; }},
-            {"edited", [&]() { return "Edited " + suffix; }},
-            {"closed", [&]() { return "Closed " + suffix; }},
-            {"reopened", [&]() { return "Reopened " + suffix; }},
-        };
-
-        if (assignee.has_value()) {
-            if (*action == "assigned") {
-                action_phrase = "Assigned " + assignee.value() + " to " + suffix;
-            } else if (*action == "unassigned") {
-                action_phrase = "Unassigned " + assignee.value() + " to " + suffix;
-            }
-        } else if (label.has_value()) {
-            if (*action == "labeled") {
-                action_phrase = "Labeled issue #" + std::to_string(issue_number.value()) + " as \"" + label.value() + "\" in";
-            }
-        } else if (action_verb_map.find(*action) != action_verb_map.end()) {
-            action_phrase = action_verb_map[*action]();
+    if (requested_reviewers.has_value()) {
+        reviewer_buffer.clear();
+        for (const std::string& reviewer : *requested_reviewers) {
+            if (!reviewer_buffer.empty()) reviewer_buffer += ',';
+            reviewer_buffer += reviewer;
         }
+        event_view.requested_reviewers = reviewer_buffer;
+    }
 
-        return action_phrase;
-    };
+    return event_view;
+}
 
-    std::function<std::string()> handle_pr_event = [&]() -> std::string {
-        std::string action_phrase;
-        const std::string suffix = "PR #" + std::to_string(pr_number.value()) + " \"" + pr_title.value() + "\" in";
-
-        /**
-        * @brief Takes a vector of usernames and constructs a pluralized string.
-        *
-        * This lambda handles both singular and plural cases. If the vector contains more than one username,
-        * it returns a pluralized string. For vectors with <=1 usernames, an empty string is returned.
-        *
-        * @param reviewers  Vector containing the requested reviewers' usernames.
-        * @return           Pluralized string.
-        */
-        auto requested_reviewers_pluralize = [&]() -> std::string {
-            // pluralize if more than one requested reviewer
-            if (requested_reviewers->size() > 1) {
-                return (requested_reviewers->size() > 2)
-                    ? ", " + requested_reviewers.value()[1] + " and others"
-                    : " and " + requested_reviewers.value()[1];
-            }
-
-            // otherwise return empty string
-            return "";
-        };
-
-        // don't require special attention, simple formula
-        std::unordered_map<std::string, std::function<std::string()>> action_verb_map = {
-            {"opened", [&]() { return "Opened " + suffix; }},
-            {"edited", [&]() { return "Edited " + suffix; }},
-            {"closed", [&]() { return "Closed " + suffix; }},
-            {"reopened", [&]() { return "Reopened " + suffix; }},
-            {"synchronize", [&]() { return "Updated " + suffix; }},
-        };
-
-        // special cases
-        if (label.has_value()) {
-            if (std::strcmp(action.value().c_str(), "labeled") == 0) {
-                // user added a label to a PR
-                action_phrase = "Labeled PR #" + std::to_string(pr_number.value()) + " \"" + label.value() + "\" in";
-            } else if (std::strcmp(action.value().c_str(), "unlabeled") == 0) {
-                // user removed a label from a PR
-                action_phrase = "Removed label \"" + label.value() + "\" from PR #" + std::to_string(pr_number.value()) + " in";
-            }
-        } else if (assignee.has_value()) {
-            if (std::strcmp(action.value().c_str(), "assigned") == 0) {
-                // user assigned someone to a PR
-                action_phrase = "Assigned " + assignee.value() + " to " + suffix;
-            } else if (std::strcmp(action.value().c_str(), "edited") == 0) {
-                // user unassigned someone from a PR
-                action_phrase = "Unassigned " + assignee.value() + " from " + suffix;
-            }
-        } else if (requested_reviewers.has_value() && !requested_reviewers.value().empty()) {
-            if (std::strcmp(action.value().c_str(), "review_requested") == 0) {
-                // user requested a PR review from someone
-                action_phrase = "Requested a review of PR #" +
-                    std::to_string(pr_number.value()) + " \"" +
-                    pr_title.value() + "\" from " +
-                    requested_reviewers.value()[0] +
-                    requested_reviewers_pluralize() + " in";
-            } else if (std::strcmp(action.value().c_str(), "review_request_removed") == 0) {
-                // user removed a PR review request
-                action_phrase = "Rescinded a review request for " +
-                    requested_reviewers.value()[0] +
-                    requested_reviewers_pluralize() + " on " + suffix;
-            }
-        } else {
-            if (action_verb_map.find(*action) != action_verb_map.end()) {
-                action_phrase = action_verb_map[*action]();
-            }
+/**
+ * @brief Resets every field, keeping the capacity of the strings for the next event.
+ */
+void Event::clear() {
+    id = 0;
+    type = EventType::Unknown;
+    type_name.clear();
+    time = 0;
+    repo_name.clear();
+    issue_number.reset();
+    pr_number.reset();
+    commit_count.reset();
+    action = EventAction::None;
+    action_name.clear();
+    assignee.reset();
+    label.reset();
+    collaborator.reset();
+    pr_title.reset();
+    requested_reviewers.reset();
+}
+
+/**
+ * @brief Returns the event's type as Github names it.
+ */
+std::string_view EventView::type_str() const {
+    return (type == EventType::Unknown) ? type_name : to_string(type);
+}
+
+/**
+ * @brief Returns the event's action as Github names it (empty if it has none).
+ */
+std::string_view EventView::action_str() const {
+    return (action == EventAction::Unknown) ? action_name : to_string(action);
+}
+
+/**
+ * @brief Returns the number of requested reviewers.
+ */
+size_t EventView::reviewer_count() const {
+    if (!requested_reviewers.has_value() || requested_reviewers->empty()) return 0;
+    return std::count(requested_reviewers->begin(), requested_reviewers->end(), ',') + 1;
+}
+
+/**
+ * @brief Returns the username of the requested reviewer at the given index.
+ */
+std::string_view EventView::reviewer(size_t index) const {
+    std::string_view rest = requested_reviewers.value_or(std::string_view());
+    for (; index > 0; --index) {
+        const size_t comma = rest.find(',');
+        rest = (comma == std::string_view::npos) ? std::string_view() : rest.substr(comma + 1);
+    }
+    return rest.substr(0, rest.find(','));
+}
+
+namespace {
+
+// phrase building blocks. NOTE: a rendered action phrase should NEVER end with whitespace, EVER
+
+std::string_view issue_comment_verb(EventAction action) {
+    switch (action) {
+        case EventAction::Created: return "Left";
+        case EventAction::Edited: return "Edited";
+        case EventAction::Deleted: return "Deleted";
+        default: return {};
+    }
+}
+
+std::string_view issue_verb(EventAction action) {
+    switch (action) {
+        case EventAction::Opened: return "Opened";
+        case EventAction::Edited: return "Edited";
+        case EventAction::Closed: return "Closed";
+        case EventAction::Reopened: return "Reopened";
+        default: return {};
+    }
+}
+
+// don't require special attention, simple formula
+std::string_view pr_verb(EventAction action) {
+    switch (action) {
+        case EventAction::Opened: return "Opened";
+        case EventAction::Edited: return "Edited";
+        case EventAction::Closed: return "Closed";
+        case EventAction::Reopened: return "Reopened";
+        case EventAction::Synchronize: return "Updated";
+        default: return {};
+    }
+}
+
+// events whose phrase only depends on their type
+std::string_view atomic_event_phrase(EventType type) {
+    switch (type) {
+        case EventType::CommitComment: return "Left a commit comment on";
+        case EventType::Create: return "Created a new branch/tag in";
+        case EventType::Delete: return "Deleted a branch/event in";
+        case EventType::Fork: return "Forked";
+        case EventType::Gollum: return "Created/updated the wiki for";
+        case EventType::Public: return "Made repo public:";
+        case EventType::Release: return "Published a new release of";
+        case EventType::Sponsorship: return "Sponsorship listing created for";
+        case EventType::Watch: return "Starred";
+        default: return {};
+    }
+}
+
+void append_number(std::string& out, int number) {
+    char digits[16];
+    const auto result = std::to_chars(digits, digits + sizeof(digits), number);
+    out.append(digits, result.ptr);
+}
+
+// `PR #<number> "<title>"`
+void append_pr(std::string& out, const EventView& event) {
+    out += "PR #";
+    append_number(out, event.pr_number.value());
+    out += " \"";
+    out += event.pr_title.value();
+    out += '"';
+}
+
+// the first requested reviewer, plus "and <second>" or ", <second> and others"
+void append_reviewers(std::string& out, const EventView& event) {
+    const size_t count = event.reviewer_count();
+
+    out += event.reviewer(0);
+    if (count > 1) {
+        out += (count > 2) ? ", " : " and ";
+        out += event.reviewer(1);
+        if (count > 2) out += " and others";
+    }
+}
+
+void append_issue_comment_phrase(std::string& out, const EventView& event) {
+    const std::string_view verb = issue_comment_verb(event.action);
+    if (verb.empty()) return;
+
+    out += verb;
+    out += " a comment on issue #";
+    append_number(out, event.issue_number.value());
+    out += " in";
+}
+
+void append_issue_phrase(std::string& out, const EventView& event) {
+    const EventAction action = event.action;
+
+    if (event.assignee.has_value()) {
+        if (action == EventAction::Assigned || action == EventAction::Unassigned) {
+            out += (action == EventAction::Assigned) ? "Assigned " : "Unassigned ";
+            out += *event.assignee;
+            out += (action == EventAction::Assigned) ? " to issue #" : " from issue #";
+            append_number(out, event.issue_number.value());
+            out += " in";
+        }
+    } else if (event.label.has_value()) {
+        if (action == EventAction::Labeled) {
+            out += "Labeled issue #";
+            append_number(out, event.issue_number.value());
+            out += " as \"";
+            out += *event.label;
+            out += "\" in";
         }
+    } else if (const std::string_view verb = issue_verb(action); !verb.empty()) {
+        out += verb;
+        out += " issue #";
+        append_number(out, event.issue_number.value());
+        out += " in";
+    }
+}
 
-        return action_phrase;
-    };
+void append_pr_phrase(std::string& out, const EventView& event) {
+    const EventAction action = event.action;
+    const bool labeling = action == EventAction::Labeled || action == EventAction::Unlabeled;
+    const bool assigning = action == EventAction::Assigned || action == EventAction::Unassigned;
+    const bool requesting = action == EventAction::ReviewRequested || action == EventAction::ReviewRequestRemoved;
 
-    std::function<std::string()> handle_pr_review_thread_event = [&]() -> std::string {
-        if (std::strcmp(action.value().c_str(), "resolved") == 0) {
-            // user marked a PR review thread as resolved
-            return "Marked a review comment thread as resolved in PR #" + std::to_string(pr_number.value()) + " \"" + pr_title.value() + "\" in";
-        } else if (std::strcmp(action.value().c_str(), "unresolved") == 0) {
-            // user marked a PR review thread as unresolved
-            return "Marked a review comment thread as unresolved in PR #" + std::to_string(pr_number.value()) + " \"" + pr_title.value() + "\" in";
+    // special cases, keyed on the action: a PR opened with a label, assignee or pending reviewers
+    // is still just opened
+    if (labeling && event.label.has_value()) {
+        if (action == EventAction::Labeled) {
+            // user added a label to a PR
+            out += "Labeled PR #";
+            append_number(out, event.pr_number.value());
+            out += " \"";
+            out += *event.label;
+            out += "\" in";
         } else {
-            // something's gone horribly wrong
-            return "Whoops!";
+            // user removed a label from a PR
+            out += "Removed label \"";
+            out += *event.label;
+            out += "\" from PR #";
+            append_number(out, event.pr_number.value());
+            out += " in";
         }
-    };
+    } else if (assigning && event.assignee.has_value()) {
+        // user (un)assigned someone to/from a PR
+        out += (action == EventAction::Assigned) ? "Assigned " : "Unassigned ";
+        out += *event.assignee;
+        out += (action == EventAction::Assigned) ? " to " : " from ";
+        append_pr(out, event);
+        out += " in";
+    } else if (requesting && event.reviewer_count() > 0) {
+        if (action == EventAction::ReviewRequested) {
+            // user requested a PR review from someone
+            out += "Requested a review of ";
+            append_pr(out, event);
+            out += " from ";
+            append_reviewers(out, event);
+            out += " in";
+        } else {
+            // user removed a PR review request
+            out += "Rescinded a review request for ";
+            append_reviewers(out, event);
+            out += " on ";
+            append_pr(out, event);
+            out += " in";
+        }
+    } else if (const std::string_view verb = pr_verb(action); !verb.empty()) {
+        out += verb;
+        out += ' ';
+        append_pr(out, event);
+        out += " in";
+    }
+}
 
-    std::function<std::string()> handle_pr_review_comment_event = [&]() -> std::string {
-        return "Left a comment in a review of PR #" + std::to_string(pr_number.value()) + " \"" + pr_title.value() + "\" in";
-    };
+// for a type and action that none of the phrases cover: `<type> (<action>) in`
+void append_fallback_phrase(std::string& out, const EventView& event) {
+    const std::string_view type = event.type_str();
+    out += type.empty() ? "Unknown event" : type;
+    if (const std::string_view action = event.action_str(); !action.empty()) {
+        out += " (";
+        out += action;
+        out += ')';
+    }
+    out += " in";
+}
 
-    std::function<std::string()> handle_pr_review_event = [&]() -> std::string {
-        return "Reviewed PR #" + std::to_string(pr_number.value()) + " \"" + pr_title.value() + "\" in";
-    };
+}  // namespace
 
-    if (pr_title.has_value()) {
-        std::unordered_map<std::string, std::function<std::string()>> pr_event_handle_map = {
-            {"PullRequestEvent", handle_pr_event},
-            {"PullRequestReviewThreadEvent", handle_pr_review_thread_event},
-            {"PullRequestReviewCommentEvent", handle_pr_review_comment_event},
-            {"PullRequestReviewEvent", handle_pr_review_event}
-        };
+/**
+* @brief Returns a human-readable string representation of the Event.
+*
+* @return  A string containing event information.
+*/
+std::string EventView::to_str() const {
+    std::string str;
+    append_to(str);
+    return str;
+}
 
-        action_phrase = pr_event_handle_map[type_c_str]();
+/**
+ * @brief Appends a human-readable representation of the event to a buffer.
+ *
+ * Dispatch is a switch over the interned type and action, and the phrase is written straight into
+ * the buffer, so rendering into a buffer with enough capacity doesn't allocate. A combination that
+ * has no phrase of its own, such as an action added to the API later, is rendered by its type and
+ * action instead.
+ *
+ * @param out  The buffer to append to.
+ */
+void EventView::append_to(std::string& out) const {
+    const size_t start = out.size();
 
-    } else if (issue_number.has_value()) {
-        std::unordered_map<std::string, std::function<std::string()>> issue_event_handle_map = {
-            {"IssueCommentEvent", handle_issue_comment_event},
-            {"IssuesEvent", handle_issue_event},
-        };
+    if (pr_title.has_value()) {
+        switch (type) {
+            case EventType::PullRequest:
+                append_pr_phrase(out, *this);
+                break;
+            case EventType::PullRequestReviewThread:
+                if (action == EventAction::Resolved || action == EventAction::Unresolved) {
+                    // user marked a PR review thread as (un)resolved
+                    out += "Marked a review comment thread as ";
+                    out += to_string(action);
+                    out += " in ";
+                    append_pr(out, *this);
+                    out += " in";
+                }
+                break;
+            case EventType::PullRequestReviewComment:
+                out += "Left a comment in a review of ";
+                append_pr(out, *this);
+                out += " in";
+                break;
+            case EventType::PullRequestReview:
+                out += "Reviewed ";
+                append_pr(out, *this);
+                out += " in";
+                break;
+            default:
+                break;
+        }
 
-        action_phrase = issue_event_handle_map[type_c_str]();
+    } else if (issue_number.has_value()) {
+        switch (type) {
+            case EventType::IssueComment:
+                append_issue_comment_phrase(out, *this);
+                break;
+            case EventType::Issues:
+                append_issue_phrase(out, *this);
+                break;
+            default:
+                break;
+        }
 
     } else if (collaborator.has_value()) {
         // user added a collaborator to a repo
-        action_phrase = "Added " + collaborator.value() + " as a collaborator on";
+        out += "Added ";
+        out += *collaborator;
+        out += " as a collaborator on";
         // NOTE: wasn't able to find other potential actions (aside from edited), look into this
 
     } else if (commit_count.has_value()) {
-        auto pluralize_commit_count = [&]() -> std::string {
-            return (commit_count.value() == 1 ? " commit" : " commits");
-        };
-
         // user pushed commit(s)
-        action_phrase = "Pushed " + std::to_string(commit_count.value()) + pluralize_commit_count() + " to";
-
-    } else {
-        std::unordered_map<std::string, std::string> atomic_event_verb_map = {
-            {"CommitCommentEvent", "Left a commit comment on"},
-            {"CreateEvent", "Created a new branch/tag in"},
-            {"DeleteEvent", "Deleted a branch/event in"},
-            {"ForkEvent", "Forked"},
-            {"GollumEvent", "Created/updated the wiki for"},
-            {"PublicEvent", "Made repo public:"},
-            {"ReleaseEvent", "Published a new release of"},
-            {"SponsorshipEvent", "Sponsorship listing created for"},
-            {"WatchEvent", "Starred"}
-        };
-
-        if (atomic_event_verb_map.find(type_c_str) != atomic_event_verb_map.end()) {
-            action_phrase = atomic_event_verb_map[type_c_str];
-        } else {
-            // something must've gone horribly wrong
-            action_phrase = "Whoops!";
-        }
+        out += "Pushed ";
+        append_number(out, *commit_count);
+        out += (*commit_count == 1) ? " commit to" : " commits to";
 
+    } else if (const std::string_view phrase = atomic_event_phrase(type); !phrase.empty()) {
+        out += phrase;
     }
 
-    return action_phrase + " " + repo_name;
-};
+    if (out.size() == start) {
+        append_fallback_phrase(out, *this);
+    }
+    out += ' ';
+    out += repo_name;
+}
@@ -0,0 +1,156 @@
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "event_cache.hpp"
+
+static const char EVENT_CACHE_MAGIC[8] = {'G', 'H', 'A', 'E', 'V', 'N', 'T', 'S'};
+static const std::uint32_t EVENT_CACHE_VERSION = 4;
+
+/**
+ * @brief Writes events to a binary event cache file, replacing it atomically.
+ *
+ * @param path    Where to write the cache.
+ * @param events  The events to cache.
+ * @param tag     Identifies what the events were cached from, checked by readers before use.
+ * @return        Whether the file was written.
+ */
+bool write_event_cache(const std::string& path, const EventStore& events, std::string_view tag) {
+    const std::vector<PackedEvent>& records = events.packed();
+    const std::string_view strings = events.arena();
+
+    EventCacheHeader header = {};
+    std::memcpy(header.magic, EVENT_CACHE_MAGIC, sizeof(header.magic));
+    header.version = EVENT_CACHE_VERSION;
+    header.event_count = (std::uint32_t)records.size();
+    // the tag goes at the end of the blob
+    header.tag = {(std::uint32_t)strings.size(), (std::uint32_t)tag.size()};
+    header.strings_size = strings.size() + tag.size();
+
+    const std::string temp_path = path + ".tmp" + std::to_string(getpid());
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            return false;
+        }
+
+        file.write((const char*)&header, sizeof(header));
+        file.write((const char*)records.data(), records.size() * sizeof(PackedEvent));
+        file.write(strings.data(), strings.size());
+        file.write(tag.data(), tag.size());
+
+        if (!file) {
+            std::filesystem::remove(temp_path);
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temp_path, path, error);
+    if (error) {
+        std::filesystem::remove(temp_path, error);
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Maps a binary event cache file.
+ *
+ * A missing, truncated or otherwise malformed file leaves the cache invalid (and empty).
+ *
+ * @param path  The cache file.
+ */
+MappedEventCache::MappedEventCache(const std::string& path) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return;
+    }
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) == 0 && (size_t)file_stat.st_size >= sizeof(EventCacheHeader)) {
+        mapping_size = file_stat.st_size;
+        mapping = mmap(nullptr, mapping_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+            mapping = nullptr;
+        }
+    }
+    // the mapping stays valid after the descriptor is closed
+    close(fd);
+
+    if (!mapping) {
+        return;
+    }
+
+    header = (const EventCacheHeader*)mapping;
+    records = (const PackedEvent*)(header + 1);
+    strings = (const char*)(records + header->event_count);
+
+    if (!validate()) {
+        header = nullptr;
+        records = nullptr;
+        strings = nullptr;
+    }
+}
+
+MappedEventCache::~MappedEventCache() {
+    if (mapping) {
+        munmap(mapping, mapping_size);
+    }
+}
+
+std::string_view MappedEventCache::tag() const {
+    return header ? string_at(header->tag) : std::string_view();
+}
+
+/**
+ * @brief Returns a view of the event at the given index, pointing into the mapping.
+ */
+EventView MappedEventCache::operator[](size_t index) const {
+    return unpack_event(records[index], strings);
+}
+
+/**
+ * @brief Checks the header and that every record and string lies within the mapping.
+ */
+bool MappedEventCache::validate() const {
+    if (std::memcmp(header->magic, EVENT_CACHE_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != EVENT_CACHE_VERSION) {
+        return false;
+    }
+
+    const std::uint64_t expected_size = sizeof(EventCacheHeader) +
+        (std::uint64_t)header->event_count * sizeof(PackedEvent) + header->strings_size;
+    if (expected_size != mapping_size) {
+        return false;
+    }
+
+    auto in_bounds = [&](StringRef ref) {
+        return (std::uint64_t)ref.offset + ref.length <= header->strings_size;
+    };
+
+    if (!in_bounds(header->tag)) return false;
+    for (size_t i = 0; i < header->event_count; ++i) {
+        const PackedEvent& record = records[i];
+        if (record.type >= EventType::Count || record.action >= EventAction::Count ||
+            !in_bounds(record.type_name) || !in_bounds(record.action_name) ||
+            !in_bounds(record.repo_name) ||
+            !in_bounds(record.assignee) || !in_bounds(record.label) ||
+            !in_bounds(record.collaborator) || !in_bounds(record.pr_title) ||
+            !in_bounds(record.requested_reviewers)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+std::string_view MappedEventCache::string_at(StringRef ref) const {
+    return std::string_view(strings + ref.offset, ref.length);
+}
@@ -0,0 +1,132 @@
+#include "event_store.hpp"
+
+/**
+ * @brief Returns a view of a packed event.
+ *
+ * @param record   The event.
+ * @param strings  The arena its StringRefs point into.
+ * @return         A view pointing into the arena.
+ */
+EventView unpack_event(const PackedEvent& record, const char* strings) {
+    auto string_at = [strings](StringRef ref) { return std::string_view(strings + ref.offset, ref.length); };
+
+    EventView event_view = {
+        record.id,
+        record.type,
+        string_at(record.type_name),
+        record.time,
+        string_at(record.repo_name),
+        std::nullopt,
+        std::nullopt,
+        std::nullopt,
+        record.action,
+        string_at(record.action_name),
+        std::nullopt,
+        std::nullopt,
+        std::nullopt,
+        std::nullopt,
+        std::nullopt
+    };
+
+    if (record.present & PackedEvent::HasIssueNumber) event_view.issue_number = record.issue_number;
+    if (record.present & PackedEvent::HasPrNumber) event_view.pr_number = record.pr_number;
+    if (record.present & PackedEvent::HasCommitCount) event_view.commit_count = record.commit_count;
+    if (record.present & PackedEvent::HasAssignee) event_view.assignee = string_at(record.assignee);
+    if (record.present & PackedEvent::HasLabel) event_view.label = string_at(record.label);
+    if (record.present & PackedEvent::HasCollaborator) event_view.collaborator = string_at(record.collaborator);
+    if (record.present & PackedEvent::HasPrTitle) event_view.pr_title = string_at(record.pr_title);
+    if (record.present & PackedEvent::HasRequestedReviewers) {
+        event_view.requested_reviewers = string_at(record.requested_reviewers);
+    }
+
+    return event_view;
+}
+
+/**
+ * @brief Appends a copy of an event to the store.
+ */
+void EventStore::add(const Event& event) {
+    PackedEvent record = {};
+
+    record.id = event.id;
+    record.type = event.type;
+    record.type_name = add_string(event.type_name);
+    record.action = event.action;
+    record.action_name = add_string(event.action_name);
+    record.time = event.time;
+    record.repo_name = add_string(event.repo_name);
+
+    if (event.issue_number) {
+        record.present |= PackedEvent::HasIssueNumber;
+        record.issue_number = *event.issue_number;
+    }
+    if (event.pr_number) {
+        record.present |= PackedEvent::HasPrNumber;
+        record.pr_number = *event.pr_number;
+    }
+    if (event.commit_count) {
+        record.present |= PackedEvent::HasCommitCount;
+        record.commit_count = *event.commit_count;
+    }
+    if (event.assignee) {
+        record.present |= PackedEvent::HasAssignee;
+        record.assignee = add_string(*event.assignee);
+    }
+    if (event.label) {
+        record.present |= PackedEvent::HasLabel;
+        record.label = add_string(*event.label);
+    }
+    if (event.collaborator) {
+        record.present |= PackedEvent::HasCollaborator;
+        record.collaborator = add_string(*event.collaborator);
+    }
+    if (event.pr_title) {
+        record.present |= PackedEvent::HasPrTitle;
+        record.pr_title = add_string(*event.pr_title);
+    }
+    if (event.requested_reviewers) {
+        record.present |= PackedEvent::HasRequestedReviewers;
+        record.requested_reviewers.offset = (std::uint32_t)strings.size();
+        for (size_t i = 0; i < event.requested_reviewers->size(); ++i) {
+            if (i > 0) strings += ',';
+            strings += (*event.requested_reviewers)[i];
+        }
+        record.requested_reviewers.length = (std::uint32_t)(strings.size() - record.requested_reviewers.offset);
+    }
+
+    records.push_back(record);
+}
+
+/**
+ * @brief Makes room for a number of events and string bytes without reallocating.
+ */
+void EventStore::reserve(size_t events, size_t string_bytes) {
+    records.reserve(events);
+    strings.reserve(string_bytes);
+}
+
+/**
+ * @brief Gives back the capacity that growing the store left unused, once no more events will be added.
+ */
+void EventStore::shrink_to_fit() {
+    records.shrink_to_fit();
+    strings.shrink_to_fit();
+}
+
+void EventStore::clear() {
+    records.clear();
+    strings.clear();
+}
+
+/**
+ * @brief Returns a view of the event at the given index, pointing into the store.
+ */
+EventView EventStore::operator[](size_t index) const {
+    return unpack_event(records[index], strings.data());
+}
+
+StringRef EventStore::add_string(std::string_view str) {
+    const StringRef ref = {(std::uint32_t)strings.size(), (std::uint32_t)str.size()};
+    strings.append(str);
+    return ref;
+}
@@ -0,0 +1,406 @@
+#include <algorithm>
+#include <charconv>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+#include "fetching.hpp"
+
+EventFetcher::EventFetcher(HttpClient& client, FetchOptions options)
+    : client(client), options(std::move(options)) {}
+
+/**
+ * @brief Fetches the events of every user and hands them to the callbacks in input order.
+ *
+ * @param usernames  The users to fetch events for.
+ * @param callbacks  Receive each user's start, events (newest first) and completion.
+ */
+void EventFetcher::fetch(const std::vector<std::string>& usernames, FetchCallbacks callbacks) {
+    this->callbacks = std::move(callbacks);
+    users.clear();
+    requests.clear();
+    head_user = 0;
+    head_page = 0;
+    hints = ServerHints();
+    answered = 0;
+
+    for (const std::string& username : usernames) {
+        users.push_back(UserFetch());
+        users.back().username = username;
+        // users are handed on in input order, so an earlier user's later pages go before a later user's first
+        users.back().priority = -(int)(users.size() - 1);
+    }
+    if (options.last_read.size() == users.size()) {
+        // stalest first: when the rate limit only lets some requests through, the users that have
+        // gone longest without being read get them
+        std::vector<size_t> order(users.size());
+        for (size_t user = 0; user < order.size(); ++user) order[user] = user;
+        std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+            return options.last_read[a] < options.last_read[b];
+        });
+        for (size_t rank = 0; rank < order.size(); ++rank) {
+            users[order[rank]].priority = -(int)rank;
+        }
+    }
+    for (size_t user = 0; user < users.size(); ++user) {
+        queue_page(user, 1);
+    }
+
+    // hand on the first user's start before any of its events stream in
+    advance();
+    client.get_all(requests, options.max_in_flight);
+}
+
+/**
+ * @brief Queues the request for one page of a user's events.
+ */
+void EventFetcher::queue_page(size_t user, size_t number) {
+    UserFetch& fetch = users[user];
+    const size_t page = fetch.pages.size();
+
+    std::string endpoint = options.api_url + "/users/" + fetch.username + "/events";
+    if (options.all_pages) {
+        endpoint += "?per_page=" + std::to_string(per_page) + "&page=" + std::to_string(number);
+    }
+
+    fetch.pages.push_back(PageFetch());
+    PageFetch& page_fetch = fetch.pages.back();
+    page_fetch.number = number;
+    page_fetch.parser = std::make_unique<EventStreamParser>([this, user, page](const Event& event) {
+        handle_event(user, page, event);
+    }, &options.filter);
+
+    requests.push_back({
+        std::move(endpoint),
+        [this, user, page](const char* data, size_t size) { handle_data(user, page, data, size); },
+        [this, user, page](const HttpResult& result) { complete_page(user, page, result); },
+        [this, user, page](std::string_view name, std::string_view value) { handle_header(user, page, name, value); },
+        nullptr
+    });
+    requests.back().priority = fetch.priority;
+    if (options.cache) {
+        requests.back().on_not_modified = [this, user, page](const CachedResponse& cached) {
+            return handle_not_modified(user, page, cached);
+        };
+    }
+    page_fetch.request = &requests.back();
+}
+
+/**
+ * @brief Keeps the page being parsed plus up to `prefetch` pages after it queued or in flight.
+ */
+void EventFetcher::queue_more_pages(size_t user) {
+    UserFetch& fetch = users[user];
+
+    while (fetch.pages.size() < fetch.page_count && fetch.pages.size() - fetch.pages_done <= options.prefetch) {
+        queue_page(user, fetch.pages.size() + 1);
+    }
+}
+
+void EventFetcher::handle_data(size_t user, size_t page, const char* data, size_t size) {
+    PageFetch& page_fetch = users[user].pages[page];
+    EventStreamParser& parser = *page_fetch.parser;
+
+    if (!options.tracer) {
+        parser.feed(data, size);
+    } else {
+        const Tracer::Clock::time_point start = Tracer::Clock::now();
+        const Tracer::Clock::duration rendered_before = page_fetch.render_time;
+        if (page_fetch.bytes == 0) page_fetch.parse_start = start;
+        page_fetch.bytes += size;
+
+        parser.feed(data, size);
+        // the events are handed on from inside the parser, and that counts as rendering them
+        page_fetch.parse_time += (Tracer::Clock::now() - start) - (page_fetch.render_time - rendered_before);
+    }
+
+    // events the filter rejected never reach handle_event, but they're just as good a sign that
+    // everything after them is older than --since
+    const std::optional<std::int64_t> oldest = parser.oldest_time();
+    if (options.filter.since && oldest && *oldest < *options.filter.since) {
+        cut_off(user, page + 1);
+    }
+}
+
+void EventFetcher::handle_event(size_t user, size_t page, const Event& event) {
+    UserFetch& fetch = users[user];
+    PageFetch& page_fetch = fetch.pages[page];
+    if (page >= fetch.page_count) {
+        // past the cutoff
+        return;
+    }
+
+    ++page_fetch.parsed;
+    const bool at_head = user == head_user && page == head_page;
+    if (options.cache || !at_head) {
+        if (page_fetch.events.empty()) {
+            // one allocation for the records and one for the strings, for the whole page
+            const size_t expected = options.all_pages ? per_page : default_per_page;
+            page_fetch.events.reserve(expected, expected * string_bytes_per_event);
+        }
+        // a cached page has to be complete, whatever is shown of it
+        page_fetch.events.add(event);
+    }
+
+    if (options.filter.since && event.time < *options.filter.since) {
+        // events come newest first, so nothing after this one is wanted either
+        cut_off(user, page + 1);
+        return;
+    }
+
+    if (at_head) {
+        std::string reviewer_buffer;
+        hand_on(user, page, event.view(reviewer_buffer));
+        page_fetch.handed_on = page_fetch.events.size();
+    }
+    page_fetch.shown = page_fetch.events.size();
+}
+
+void EventFetcher::handle_header(size_t user, size_t page, std::string_view name, std::string_view value) {
+    UserFetch& fetch = users[user];
+
+    if (name == "etag") {
+        fetch.pages[page].etag = value;
+    } else if (name == "x-poll-interval") {
+        long interval = 0;
+        std::from_chars(value.data(), value.data() + value.size(), interval);
+        hints.poll_interval = std::max(hints.poll_interval.value_or(0), interval);
+    } else if (name == "x-ratelimit-remaining") {
+        long remaining = 0;
+        std::from_chars(value.data(), value.data() + value.size(), remaining);
+        hints.rate_limit_remaining = std::min(hints.rate_limit_remaining.value_or(remaining), remaining);
+    } else if (name == "x-ratelimit-reset") {
+        std::int64_t reset = 0;
+        std::from_chars(value.data(), value.data() + value.size(), reset);
+        hints.rate_limit_reset = std::max(hints.rate_limit_reset.value_or(0), reset);
+    } else if (name == "link" && page == 0 && options.all_pages) {
+        const size_t last_page = std::min(last_page_from_link_header(value), max_pages);
+        if (last_page > fetch.page_count) {
+            fetch.page_count = last_page;
+            queue_more_pages(user);
+        }
+    }
+}
+
+/**
+ * @brief Serves a page the server says hasn't changed from its binary event cache, if there is one.
+ *
+ * @return  true if the cached events will be used, false to have the cached JSON replayed instead.
+ */
+bool EventFetcher::handle_not_modified(size_t user, size_t page, const CachedResponse& cached) {
+    PageFetch& page_fetch = users[user].pages[page];
+
+    auto cached_events = std::make_unique<MappedEventCache>(events_path(page_fetch));
+    if (!cached_events->valid() || cached_events->tag() != cached.etag) {
+        return false;
+    }
+
+    page_fetch.cached_events = std::move(cached_events);
+    return true;
+}
+
+void EventFetcher::complete_page(size_t user, size_t page, const HttpResult& result) {
+    UserFetch& fetch = users[user];
+    PageFetch& page_fetch = fetch.pages[page];
+    if (result.status != 0) {
+        ++answered;
+    }
+
+    if (page < fetch.page_count) {
+        std::string error;
+        const bool parsed = page_fetch.cached_events || (result.ok && page_fetch.parser->finish(&error));
+        if (!result.ok || !parsed) {
+            if (fetch.ok) fetch.error = result.ok ? error : result.error;
+            fetch.ok = false;
+            // without this page the ones after it would leave a gap
+            cut_off(user, page + 1);
+        } else if (options.cache && !page_fetch.cached_events && !page_fetch.etag.empty() &&
+                   !page_fetch.request->cancelled && (result.status == 200 || result.from_cache)) {
+            write_event_cache(events_path(page_fetch), page_fetch.events, page_fetch.etag);
+        }
+    }
+
+    page_fetch.done = true;
+    page_fetch.parser.reset();
+    ++fetch.pages_done;
+
+    queue_more_pages(user);
+    advance();
+}
+
+/**
+ * @brief Passes an event to on_event if it's wanted, and stops the user's paging once on_event has had enough.
+ */
+void EventFetcher::hand_on(size_t user, size_t page, const EventView& event) {
+    UserFetch& fetch = users[user];
+    if (fetch.stopped || !options.filter.accepts_time(event.time)) return;
+
+    bool wanted;
+    if (!options.tracer) {
+        wanted = callbacks.on_event(user, event);
+    } else {
+        PageFetch& page_fetch = fetch.pages[page];
+        const Tracer::Clock::time_point start = Tracer::Clock::now();
+        if (page_fetch.rendered++ == 0) page_fetch.render_start = start;
+        wanted = callbacks.on_event(user, event);
+        page_fetch.render_time += Tracer::Clock::now() - start;
+    }
+    if (!wanted) {
+        fetch.stopped = true;
+        cut_off(user, page + 1);
+    }
+}
+
+/**
+ * @brief Returns where a page's binary event cache goes.
+ *
+ * The parser leaves out the events the filter rejects by content, so pages parsed with different
+ * filters are cached separately.
+ */
+std::string EventFetcher::events_path(const PageFetch& page_fetch) const {
+    if (!options.filter.filters_content()) {
+        return options.cache->events_path(page_fetch.request->endpoint);
+    }
+    return options.cache->events_path(page_fetch.request->endpoint + "\n" + options.filter.content_key());
+}
+
+/**
+ * @brief Stops a user's paging early: the given page and everything after it is dropped.
+ */
+void EventFetcher::cut_off(size_t user, size_t first_dropped) {
+    UserFetch& fetch = users[user];
+    if (first_dropped >= fetch.page_count) return;
+
+    fetch.page_count = first_dropped;
+    for (size_t i = first_dropped; i < fetch.pages.size(); ++i) {
+        fetch.pages[i].request->cancelled = true;
+        fetch.pages[i].events = EventStore();
+        fetch.pages[i].handed_on = fetch.pages[i].shown = 0;
+    }
+}
+
+/**
+ * @brief Hands on everything that is no longer blocked by an unfinished page before it.
+ */
+void EventFetcher::advance() {
+    while (head_user < users.size()) {
+        UserFetch& fetch = users[head_user];
+
+        if (!fetch.started) {
+            fetch.started = true;
+            if (callbacks.on_user_start) callbacks.on_user_start(head_user);
+        }
+
+        while (head_page < fetch.page_count && head_page < fetch.pages.size()) {
+            flush_page(head_user, head_page);
+
+            if (!fetch.pages[head_page].done) return;
+            ++head_page;
+        }
+        if (head_page < fetch.page_count) {
+            // more pages are still to be queued
+            return;
+        }
+
+        if (callbacks.on_user_done) callbacks.on_user_done(head_user, fetch.ok, fetch.error);
+        ++head_user;
+        head_page = 0;
+    }
+}
+
+/**
+ * @brief Hands on the events of the head page that were held back or are served from the event cache.
+ */
+void EventFetcher::flush_page(size_t user, size_t page) {
+    PageFetch& page_fetch = users[user].pages[page];
+    const bool from_cache = page_fetch.cached_events != nullptr;
+
+    for (; page_fetch.handed_on < page_fetch.shown; ++page_fetch.handed_on) {
+        hand_on(user, page, page_fetch.events[page_fetch.handed_on]);
+    }
+    if (page_fetch.done) {
+        // nothing else will be read from the page
+        page_fetch.events = EventStore();
+        page_fetch.handed_on = page_fetch.shown = 0;
+    }
+
+    if (page_fetch.done && page_fetch.cached_events) {
+        const MappedEventCache& cached_events = *page_fetch.cached_events;
+
+        for (size_t i = 0; i < cached_events.size(); ++i) {
+            const EventView event = cached_events[i];
+            if (options.filter.since && event.time < *options.filter.since) {
+                cut_off(user, page + 1);
+                break;
+            }
+            hand_on(user, page, event);
+        }
+        page_fetch.cached_events.reset();
+    }
+
+    if (page_fetch.done && options.tracer) {
+        trace_page(user, page, from_cache);
+    }
+}
+
+/**
+ * @brief Records how long a page that's been handed on took to parse and to hand on.
+ *
+ * Pages are parsed a chunk at a time as they stream in, interleaved with other pages, so the spans
+ * start when the page's first chunk (or event) did and last as long as all of its chunks (or events)
+ * together.
+ */
+void EventFetcher::trace_page(size_t user, size_t page, bool from_cache) {
+    PageFetch& page_fetch = users[user].pages[page];
+    const std::string& username = users[user].username;
+
+    if (page_fetch.bytes > 0) {
+        options.tracer->async_span("parse", page_fetch.parse_start, page_fetch.parse_time, {
+            {"user", username},
+            {"page", (std::int64_t)page_fetch.number},
+            {"bytes", (std::int64_t)page_fetch.bytes},
+            {"events", (std::int64_t)page_fetch.parsed},
+        });
+    }
+    if (page_fetch.rendered > 0) {
+        options.tracer->async_span("render", page_fetch.render_start, page_fetch.render_time, {
+            {"user", username},
+            {"page", (std::int64_t)page_fetch.number},
+            {"events", (std::int64_t)page_fetch.rendered},
+            {"from_cache", (std::int64_t)from_cache},
+        });
+    }
+}
+
+/**
+ * @brief Reads the number of the last page out of a Link header.
+ *
+ * @param link  The header value, e.g. `<https://...&page=2>; rel="next", <https://...&page=3>; rel="last"`.
+ * @return      The last page number, or 1 if the header doesn't have one.
+ */
+size_t last_page_from_link_header(std::string_view link) {
+    size_t last_page = 1;
+
+    while (!link.empty()) {
+        const size_t comma = link.find(',');
+        const std::string_view entry = link.substr(0, comma);
+        link = (comma == std::string_view::npos) ? std::string_view() : link.substr(comma + 1);
+
+        if (entry.find("rel=\"last\"") == std::string_view::npos) continue;
+
+        const size_t url_end = entry.find('>');
+        if (url_end == std::string_view::npos) continue;
+
+        size_t param = entry.substr(0, url_end).rfind("page=");
+        // skip per_page=
+        while (param != std::string_view::npos && param > 0 && entry[param - 1] != '?' && entry[param - 1] != '&') {
+            param = entry.substr(0, param).rfind("page=");
+        }
+        if (param == std::string_view::npos) continue;
+
+        const char* first = entry.data() + param + 5;
+        std::from_chars(first, entry.data() + url_end, last_page);
+    }
+
+    return last_page;
+}
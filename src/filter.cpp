@@ -0,0 +1,131 @@
+#include <stdexcept>
+
+#include "filter.hpp"
+
+/**
+ * @brief Shows events of a type, given as Github names it (e.g. PushEvent, or just Push).
+ *
+ * @throws std::runtime_error if it isn't a known event type.
+ */
+void EventFilter::add_type(std::string_view name) {
+    EventType type = event_type_from_string(name);
+    if (type == EventType::Unknown) {
+        type = event_type_from_string(std::string(name) + "Event");
+    }
+    if (type == EventType::Unknown) {
+        throw std::runtime_error("unknown event type: " + std::string(name));
+    }
+
+    types |= 1u << (unsigned)type;
+}
+
+/**
+ * @brief Shows events in repositories matching a glob, e.g. `octocat/hello-*` (`*` and `?` are wildcards).
+ */
+void EventFilter::add_repo(std::string_view glob) {
+    repo_globs.emplace_back(glob);
+}
+
+/**
+ * @brief Shows events with a payload action, e.g. opened.
+ */
+void EventFilter::add_action(std::string_view name) {
+    const EventAction action = event_action_from_string(name);
+    if (action == EventAction::Unknown) {
+        // not one we render specially, but Github may still send it
+        action_names.emplace_back(name);
+    } else {
+        actions |= 1u << (unsigned)action;
+    }
+}
+
+/**
+ * @brief Returns whether events are filtered on anything besides their time.
+ */
+bool EventFilter::filters_content() const {
+    return types != 0 || actions != 0 || !action_names.empty() || !repo_globs.empty();
+}
+
+/**
+ * @brief Returns a string that's the same for filters that accept the same content, for keying caches of filtered events.
+ */
+std::string EventFilter::content_key() const {
+    std::string key = "types=" + std::to_string(types) + ";actions=" + std::to_string(actions);
+    for (const std::string& name : action_names) {
+        key += "," + name;
+    }
+    key += ";repos=";
+    for (const std::string& glob : repo_globs) {
+        key += glob + ",";
+    }
+    return key;
+}
+
+bool EventFilter::accepts_type(EventType type) const {
+    return types == 0 || (types & (1u << (unsigned)type)) != 0;
+}
+
+bool EventFilter::accepts_repo(std::string_view repo) const {
+    if (repo_globs.empty()) return true;
+
+    for (const std::string& glob : repo_globs) {
+        if (glob_match(glob, repo)) return true;
+    }
+    return false;
+}
+
+/**
+ * @param action  The interned action (None if the event has none).
+ * @param name    The raw action, for actions that aren't interned.
+ */
+bool EventFilter::accepts_action(EventAction action, std::string_view name) const {
+    if (actions == 0 && action_names.empty()) return true;
+
+    if (action == EventAction::Unknown) {
+        for (const std::string& accepted : action_names) {
+            if (accepted == name) return true;
+        }
+        return false;
+    }
+    return (actions & (1u << (unsigned)action)) != 0;
+}
+
+bool EventFilter::accepts_time(std::int64_t time) const {
+    return (!since || time >= *since) && (!until || time <= *until);
+}
+
+/**
+ * @brief Checks every part of the filter against a whole event.
+ */
+bool EventFilter::accepts(const EventView& event) const {
+    return accepts_type(event.type) && accepts_repo(event.repo_name) && accepts_action(event.action, event.action_name) &&
+           accepts_time(event.time);
+}
+
+/**
+ * @brief Matches a string against a shell-style glob, where `*` is any run of characters and `?` any one.
+ */
+bool glob_match(std::string_view pattern, std::string_view text) {
+    size_t p = 0, t = 0;
+    // where the last `*` was, and how much of the text it has swallowed so far
+    size_t star = std::string_view::npos, star_text = 0;
+
+    while (t < text.size()) {
+        if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == text[t])) {
+            ++p;
+            ++t;
+        } else if (p < pattern.size() && pattern[p] == '*') {
+            star = p++;
+            star_text = t;
+        } else if (star != std::string_view::npos) {
+            // backtrack: let the last `*` swallow one more character
+            p = star + 1;
+            t = ++star_text;
+        } else {
+            return false;
+        }
+    }
+
+    while (p < pattern.size() && pattern[p] == '*') ++p;
+    return p == pattern.size();
+}
@@ -0,0 +1,60 @@
+#include "arena.hpp"
+#include "json_parser.hpp"
+
+namespace {
+
+// every thread parses into its own arena, reused for every document it parses
+thread_local ScratchArena scratch;
+thread_local int parse_depth = 0;  // sax_parse_json calls in progress, in case a handler parses too
+thread_local bool scratch_enabled = true;
+
+}  // namespace
+
+/**
+ * @brief Returns the calling thread's parse scratch arena (or the heap, with the arena turned off).
+ */
+std::pmr::memory_resource& parse_scratch() {
+    return scratch_enabled ? scratch.resource() : *std::pmr::new_delete_resource();
+}
+
+/**
+ * @brief Turns the calling thread's parse scratch arena off or back on, to measure what it saves.
+ *
+ * With it off, the parser's strings are allocated on the heap like any others. It mustn't be switched
+ * while the thread is parsing.
+ */
+void set_parse_scratch_enabled(bool enabled) {
+    scratch_enabled = enabled;
+}
+
+/**
+ * @brief Runs nlohmann::json's SAX parser over a document.
+ *
+ * The parser is a template over the input and the handler. Instantiating it once, here, for the
+ * abstract handler interface keeps its lexer and parser out of parsing.cpp, so they're compiled
+ * only when the library changes instead of every time one of the handlers does.
+ *
+ * The lexer's token buffer, and with it every string handed to the handler, comes from the thread's
+ * scratch arena. The arena is released in one go once the document is done, so a document's strings
+ * cost no heap allocations after the first few documents, however many of them it has.
+ *
+ * @param document  The JSON text.
+ * @param handler   Receives the document's values and structure as they are read.
+ * @return          false if the document isn't valid JSON or the handler stopped the parse.
+ */
+bool sax_parse_json(std::string_view document, nlohmann::json_sax<ScratchJson>& handler) {
+    ++parse_depth;
+    bool parsed;
+    {
+        // what ScratchJson::sax_parse does for JSON input, minus its branch for the binary formats,
+        // whose reader only works with std::string
+        auto input = nlohmann::detail::input_adapter(document.data(), document.data() + document.size());
+        nlohmann::detail::parser<ScratchJson, decltype(input)> parser(std::move(input), nullptr, true, false);
+        parsed = parser.sax_parse(&handler, true);
+    }
+    // the parser is gone, and nothing else keeps scratch memory past a parse
+    if (--parse_depth == 0) {
+        scratch.reset();
+    }
+    return parsed;
+}
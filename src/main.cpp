@@ -1,25 +1,382 @@
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <optional>
+#include <stdexcept>
 #include <string>
+#include <thread>
 #include <vector>
 #include <cstdlib>
 
+#include <unistd.h>
+
 #include <lib/cxxopts.hpp>
 
+#include "cache.hpp"
 #include "event.hpp"
-#include "parsing.hpp"
+#include "fetching.hpp"
+#include "filter.hpp"
+#include "output.hpp"
+#include "pipeline.hpp"
 #include "requests.hpp"
+#include "stats.hpp"
+#include "timestamp.hpp"
+#include "trace.hpp"
 
 #define VERSION_STRING "github-activity version 0.1.0"
 
+/**
+ * @brief Reads usernames from a file, one per line. Blank lines and lines starting with '#' are skipped.
+ *
+ * @param path  The file to read.
+ * @return      The usernames in file order.
+ */
+static std::vector<std::string> read_usernames(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("couldn't open " + path);
+    }
+
+    std::vector<std::string> usernames;
+    std::string line;
+    while (std::getline(file, line)) {
+        // trim surrounding whitespace
+        const size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#') continue;
+        const size_t last = line.find_last_not_of(" \t\r");
+
+        usernames.push_back(line.substr(first, last - first + 1));
+    }
+
+    return usernames;
+}
+
+/**
+ * @brief Reads a --since/--until time.
+ *
+ * @param option  The option's name, for the error message.
+ * @param text    An ISO-8601 UTC time, e.g. 2024-05-01 or 2024-05-01T12:00:00Z.
+ * @return        The time in seconds since the Unix epoch.
+ */
+static std::int64_t parse_time_option(const std::string& option, const std::string& text) {
+    std::int64_t seconds;
+    if (!parse_timestamp(text, seconds)) {
+        throw std::runtime_error("invalid --" + option + " time: " + text);
+    }
+    return seconds;
+}
+
+/**
+ * @brief Writes out whatever output is still buffered, and reports it if any of the output couldn't be written
+ *        (e.g. the disk filled up, or the pipe was closed).
+ *
+ * @param out  The output to finish.
+ * @return     Whether all of it was written.
+ */
+static bool finish_output(OutputWriter& out) {
+    if (out.flush()) {
+        return true;
+    }
+    std::cerr << "Error: couldn't write output" << std::endl;
+    return false;
+}
+
+/**
+ * @brief Reports that a user's events couldn't all be read, with why if it's known.
+ *
+ * @param username  The user.
+ * @param error     What the API, the parser or the transfer said was wrong; may be empty.
+ */
+static void report_user_error(const std::string& username, const std::string& error) {
+    std::cerr << "Error: couldn't read events for " << username;
+    if (!error.empty()) std::cerr << ": " << error;
+    std::cerr << std::endl;
+}
+
+/**
+ * @brief Fetches and prints the events of every user, keeping the output in input order.
+ *
+ * @param client      The client to send the requests with.
+ * @param options     How to fetch the events.
+ * @param usernames   The users to fetch events for.
+ * @param format      What to write the events as.
+ * @param show_times  Whether to follow each event with how long ago it happened.
+ * @param out         Where to write the events; it's flushed after every user.
+ * @return            Whether every user's events could be read.
+ */
+static bool print_user_events(HttpClient& client, const FetchOptions& options, const std::vector<std::string>& usernames,
+                              OutputFormat format, bool show_times, OutputWriter& out) {
+    const bool print_headers = usernames.size() > 1 && format == OutputFormat::Text;
+    EventFetcher fetcher(client, options);
+    const std::int64_t now = std::time(nullptr);
+    bool all_ok = true;
+
+    fetcher.fetch(usernames, {
+        [&](size_t user) {
+            if (print_headers) {
+                out.buffer() += usernames[user];
+                out.buffer() += ":\n";
+                out.end_line();
+            }
+        },
+        [&](size_t user, const EventView& event) {
+            append_event_record(out.buffer(), format, event, usernames[user], show_times, now);
+            out.end_line();
+            return true;
+        },
+        [&](size_t user, bool ok, const std::string& error) {
+            out.flush();
+            if (!ok) {
+                report_user_error(usernames[user], error);
+                all_ok = false;
+            }
+        }
+    });
+    return all_ok;
+}
+
+/**
+ * @brief Fetches every user's events and prints how many there were per type, repository, action and hour.
+ *
+ * @param client     The client to send the requests with.
+ * @param options    How to fetch the events.
+ * @param usernames  The users to fetch events for.
+ * @param out        Where to write the counts.
+ * @return           Whether every user's events could be read.
+ */
+static bool print_user_stats(HttpClient& client, const FetchOptions& options, const std::vector<std::string>& usernames,
+                             OutputWriter& out) {
+    EventFetcher fetcher(client, options);
+    ActivityStats stats;
+    bool all_ok = true;
+
+    fetcher.fetch(usernames, {
+        nullptr,
+        [&](size_t, const EventView& event) {
+            stats.add(event);
+            return true;
+        },
+        [&](size_t user, bool ok, const std::string& error) {
+            if (!ok) {
+                report_user_error(usernames[user], error);
+                all_ok = false;
+            }
+        }
+    });
+
+    stats.append_report(out.buffer());
+    out.flush();
+    return all_ok;
+}
+
+/**
+ * @brief Fetches every user's events and prints them through a RenderPipeline, keeping the output in input order.
+ *
+ * @param client            The client to send the requests with.
+ * @param options           How to fetch the events.
+ * @param usernames         The users to fetch events for.
+ * @param pipeline_options  How to parse, format and write them.
+ * @param out               Where to write the events (or with `stats`, the counts).
+ * @return                  Whether every user's events could be read.
+ */
+static bool pipe_user_events(HttpClient& client, const FetchOptions& options, const std::vector<std::string>& usernames,
+                             const PipelineOptions& pipeline_options, OutputWriter& out) {
+    RenderPipeline pipeline(usernames, pipeline_options, out);
+    fetch_into_pipeline(client, options, usernames, pipeline);
+    const PipelineStats stats = pipeline.finish();
+
+    if (pipeline_options.stats) {
+        pipeline.activity().append_report(out.buffer());
+        out.flush();
+    }
+    return stats.failed_users == 0;
+}
+
+/**
+ * @brief Runs recorded responses through a RenderPipeline without the network, and reports what each stage did.
+ *
+ * Every `*.json` file in the directory is a response body for one user, named after the file; they
+ * are replayed in name order. A single file is replayed on its own.
+ *
+ * @param location          Where the recorded responses are: a directory of them, or one file.
+ * @param pipeline_options  How to parse, format and write them.
+ * @param out               Where to write the events (or with `stats`, the counts).
+ * @return                  Whether every response could be read.
+ */
+static bool replay_responses(const std::string& location, const PipelineOptions& pipeline_options, OutputWriter& out) {
+    std::vector<std::filesystem::path> paths;
+    if (std::filesystem::is_regular_file(location)) {
+        paths.push_back(location);
+    } else {
+        for (const auto& entry : std::filesystem::directory_iterator(location)) {
+            if (entry.is_regular_file() && entry.path().extension() == ".json") {
+                paths.push_back(entry.path());
+            }
+        }
+    }
+    if (paths.empty()) {
+        throw std::runtime_error("no recorded responses (*.json) in " + location);
+    }
+    std::sort(paths.begin(), paths.end());
+
+    std::vector<std::string> usernames;
+    for (const auto& path : paths) {
+        usernames.push_back(path.stem().string());
+    }
+
+    RenderPipeline pipeline(usernames, pipeline_options, out);
+    for (size_t user = 0; user < paths.size(); ++user) {
+        std::ifstream file(paths[user], std::ios::binary);
+        PageJob job;
+        job.user = user;
+        job.body.resize(std::filesystem::file_size(paths[user]));
+        job.ok = static_cast<bool>(file.read(job.body.data(), job.body.size()));
+        if (!job.ok) job.error = "couldn't read " + paths[user].string();
+        pipeline.submit(std::move(job));
+    }
+    const PipelineStats stats = pipeline.finish();
+
+    if (pipeline_options.stats) {
+        pipeline.activity().append_report(out.buffer());
+        out.flush();
+    }
+    print_pipeline_stats(stats);
+    return stats.failed_users == 0;
+}
+
+/**
+ * @brief Works out how long to wait before the next poll.
+ *
+ * @param hints              What the last poll's response headers said.
+ * @param requests_per_poll  How many requests the last poll made, so the next one likely makes as many.
+ * @param interval           The shortest wait wanted, in seconds.
+ * @return                   The wait in seconds: at least `interval` and the API's X-Poll-Interval, and
+ *                           long enough that the remaining rate limit lasts until it resets.
+ */
+static std::int64_t next_poll_delay(const ServerHints& hints, size_t requests_per_poll, long interval) {
+    std::int64_t delay = std::max(interval, hints.poll_interval.value_or(0));
+
+    if (hints.rate_limit_remaining && hints.rate_limit_reset) {
+        const std::int64_t remaining = *hints.rate_limit_remaining;
+        const std::int64_t until_reset = std::max<std::int64_t>(*hints.rate_limit_reset - std::time(nullptr), 0);
+
+        if (remaining == 0 || remaining < (std::int64_t)requests_per_poll) {
+            delay = std::max(delay, until_reset);
+        } else {
+            delay = std::max(delay, until_reset * (std::int64_t)requests_per_poll / remaining);
+        }
+    }
+
+    return delay;
+}
+
+/**
+ * @brief Polls the events of every user until interrupted, printing only events that are new since the last poll.
+ *
+ * The client stays warm across polls, so its connections are reused, and with the response cache every poll
+ * is a conditional request: a page that hasn't changed costs a 304 and is answered from the binary event
+ * cache. A user's events are read until the newest one the previous poll had already printed.
+ *
+ * @param client      The client to send the requests with.
+ * @param options     How to fetch the events.
+ * @param usernames   The users to watch.
+ * @param format      What to write the events as.
+ * @param show_times  Whether to follow each event with how long ago it happened.
+ * @param interval    The shortest time between polls, in seconds.
+ * @param out         Where to write the events; it's flushed after every poll, and watching stops
+ *                    with an error once it can't be written.
+ */
+[[noreturn]] static void watch_user_events(HttpClient& client, const FetchOptions& options,
+                                           const std::vector<std::string>& usernames, OutputFormat format,
+                                           bool show_times, long interval, OutputWriter& out) {
+    const bool print_headers = usernames.size() > 1 && format == OutputFormat::Text;
+    std::vector<std::uint64_t> last_seen(usernames.size(), 0);  // ID of the newest event printed, per user
+    FetchOptions poll_options = options;
+    poll_options.last_read.assign(usernames.size(), 0);
+
+    while (true) {
+        EventFetcher fetcher(client, poll_options);
+        std::vector<std::uint64_t> newest = last_seen;
+        const std::int64_t now = std::time(nullptr);
+        size_t header_user = usernames.size();
+
+        fetcher.fetch(usernames, {
+            nullptr,
+            [&](size_t user, const EventView& event) {
+                if (last_seen[user] != 0 && event.id <= last_seen[user]) {
+                    // this one and everything older was printed already
+                    return false;
+                }
+                newest[user] = std::max(newest[user], event.id);
+
+                if (print_headers && header_user != user) {
+                    out.buffer() += usernames[user];
+                    out.buffer() += ":\n";
+                    out.end_line();
+                    header_user = user;
+                }
+                append_event_record(out.buffer(), format, event, usernames[user], show_times, now);
+                out.end_line();
+                return true;
+            },
+            [&](size_t user, bool ok, const std::string& error) {
+                if (ok) {
+                    poll_options.last_read[user] = now;
+                } else {
+                    out.flush();
+                    report_user_error(usernames[user], error);
+                }
+            }
+        });
+        if (options.tracer) options.tracer->flush();
+        if (!finish_output(out)) {
+            // nothing polled from now on could be written either
+            std::exit(EXIT_FAILURE);
+        }
+        last_seen = std::move(newest);
+
+        const std::int64_t delay = next_poll_delay(fetcher.server_hints(), fetcher.requests_made(), interval);
+        std::this_thread::sleep_for(std::chrono::seconds(delay));
+    }
+}
+
 int main(const int argc, const char* argv[]) {
     cxxopts::Options options("github-activity");
 
     options.add_options()
-        ("username", "The Github username to fetch information for.", cxxopts::value<std::string>())
+        ("usernames", "The Github usernames to fetch information for.", cxxopts::value<std::vector<std::string>>())
+        ("f,file", "Read usernames from a file, one per line.", cxxopts::value<std::string>())
+        ("j,concurrency", "Maximum number of concurrent requests.", cxxopts::value<size_t>()->default_value("8"))
+        ("a,all-pages", "Fetch every available page of events (up to the API's limit of 300), not just the latest.", cxxopts::value<bool>()->default_value("false"))
+        ("prefetch", "Pages per user to fetch ahead while the current one is parsed.", cxxopts::value<size_t>()->default_value("2"))
+        ("since", "Only show events created at or after this ISO-8601 UTC time, e.g. 2024-05-01 or 2024-05-01T12:00:00Z.", cxxopts::value<std::string>())
+        ("until", "Only show events created at or before this ISO-8601 UTC time.", cxxopts::value<std::string>())
+        ("type", "Only show events of these types, e.g. PushEvent,PullRequestEvent (or Push,PullRequest).", cxxopts::value<std::vector<std::string>>())
+        ("repo", "Only show events in repositories matching these globs, e.g. 'octocat/*'.", cxxopts::value<std::vector<std::string>>())
+        ("action", "Only show events with these payload actions, e.g. opened,closed.", cxxopts::value<std::vector<std::string>>())
+        ("t,times", "Show how long ago each event happened.", cxxopts::value<bool>()->default_value("false"))
+        ("format", "Output format: text, ndjson, csv or bin (length-prefixed binary records).", cxxopts::value<std::string>()->default_value("text"))
+        ("stats", "Instead of the events, print how many there were per type, repository, action and hour of the day.", cxxopts::value<bool>()->default_value("false"))
+        ("w,watch", "Keep polling and print new events as they happen.", cxxopts::value<bool>()->default_value("false"))
+        ("interval", "Shortest time between polls in watch mode, in seconds.", cxxopts::value<long>()->default_value("60"))
+        ("workers", "Parse and format pages on this many threads while the network thread keeps fetching (0 streams them in order instead).", cxxopts::value<size_t>()->default_value("0"))
+        ("line-buffered", "Write every line as soon as it's rendered instead of in batches (the default when stdout is a terminal).", cxxopts::value<bool>()->default_value("false"))
+        ("trace", "Record how long every request, parse and render took (and what libcurl spent on DNS, connecting, TLS and waiting) to this file.", cxxopts::value<std::string>())
+        ("trace-format", "Trace format: jsonl, or chrome (for chrome://tracing or Perfetto).", cxxopts::value<std::string>()->default_value("jsonl"))
+        ("replay", "Run the recorded responses (*.json) in a directory, or a single one, through the worker pipeline and report per-stage throughput.", cxxopts::value<std::string>())
+        ("cache-dir", "Where to cache responses for conditional requests.", cxxopts::value<std::string>()->default_value(ResponseCache::default_directory()))
+        ("no-cache", "Don't cache responses; always download everything.", cxxopts::value<bool>()->default_value("false"))
+        ("no-compression", "Ask for uncompressed responses instead of gzip, zstd or brotli.", cxxopts::value<bool>()->default_value("false"))
+        ("http1.1", "Use HTTP/1.1, with a connection per concurrent request, instead of multiplexing them over HTTP/2.", cxxopts::value<bool>()->default_value("false"))
+        ("cacert", "CA bundle to verify the server's certificate with, instead of the system's.", cxxopts::value<std::string>())
+        ("api-url", "Base URL of the Github API.", cxxopts::value<std::string>()->default_value("https://api.github.com"))
         ("v,version", "Display version information.", cxxopts::value<bool>()->default_value("false"))
         ("h,help", "Show this message", cxxopts::value<bool>()->default_value("false"));
-    options.parse_positional({"username"});
-    options.positional_help("<username>");
+    options.parse_positional({"usernames"});
+    options.positional_help("<username>...");
 
     auto shell_options = options.parse(argc, argv);
 
@@ -33,14 +390,131 @@ int main(const int argc, const char* argv[]) {
     }
 
     try {
-        auto username = shell_options["username"].as<std::string>();
-        const std::string endpoint = "https://api.github.com/users/" + username + "/events";
+        OutputWriter out(STDOUT_FILENO, shell_options["line-buffered"].as<bool>() || isatty(STDOUT_FILENO));
+
+        const std::string format_name = shell_options["format"].as<std::string>();
+        const std::optional<OutputFormat> format = output_format_from_string(format_name);
+        if (!format) {
+            throw std::runtime_error("unknown output format: " + format_name);
+        }
+
+        const std::string trace_format_name = shell_options["trace-format"].as<std::string>();
+        const std::optional<TraceFormat> trace_format = trace_format_from_string(trace_format_name);
+        if (!trace_format) {
+            throw std::runtime_error("unknown trace format: " + trace_format_name);
+        }
+        std::optional<Tracer> tracer;
+        if (shell_options.count("trace")) {
+            tracer.emplace(shell_options["trace"].as<std::string>(), *trace_format);
+        }
+        Tracer* const tracer_ptr = tracer ? &*tracer : nullptr;
+
+        PipelineOptions pipeline_options;
+        pipeline_options.format = *format;
+        pipeline_options.tracer = tracer_ptr;
+        pipeline_options.workers = shell_options["workers"].as<size_t>();
+        pipeline_options.show_times = shell_options["times"].as<bool>();
+        pipeline_options.now = std::time(nullptr);
+        pipeline_options.stats = shell_options["stats"].as<bool>();
+        if (pipeline_options.stats && *format != OutputFormat::Text) {
+            throw std::runtime_error("--stats only writes text");
+        }
+        EventFilter& filter = pipeline_options.filter;
+        if (shell_options.count("type")) {
+            for (const std::string& type : shell_options["type"].as<std::vector<std::string>>()) filter.add_type(type);
+        }
+        if (shell_options.count("repo")) {
+            for (const std::string& glob : shell_options["repo"].as<std::vector<std::string>>()) filter.add_repo(glob);
+        }
+        if (shell_options.count("action")) {
+            for (const std::string& action : shell_options["action"].as<std::vector<std::string>>()) filter.add_action(action);
+        }
+        if (shell_options.count("since")) {
+            filter.since = parse_time_option("since", shell_options["since"].as<std::string>());
+        }
+        if (shell_options.count("until")) {
+            filter.until = parse_time_option("until", shell_options["until"].as<std::string>());
+        }
+
+        if (shell_options.count("replay")) {
+            if (pipeline_options.workers == 0) {
+                pipeline_options.workers = std::max(std::thread::hardware_concurrency(), 1u);
+            }
+            append_stream_header(out.buffer(), *format);
+            const bool all_ok = replay_responses(shell_options["replay"].as<std::string>(), pipeline_options, out);
+            return finish_output(out) && all_ok ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+
+        std::vector<std::string> usernames;
+        if (shell_options.count("usernames")) {
+            usernames = shell_options["usernames"].as<std::vector<std::string>>();
+        }
+        if (shell_options.count("file")) {
+            const std::vector<std::string> from_file = read_usernames(shell_options["file"].as<std::string>());
+            usernames.insert(usernames.end(), from_file.begin(), from_file.end());
+        }
+        if (usernames.empty()) {
+            throw std::runtime_error("no username given");
+        }
+
+        FetchOptions fetch_options;
+        fetch_options.api_url = shell_options["api-url"].as<std::string>();
+        fetch_options.max_in_flight = shell_options["concurrency"].as<size_t>();
+        fetch_options.all_pages = shell_options["all-pages"].as<bool>();
+        fetch_options.prefetch = shell_options["prefetch"].as<size_t>();
+        fetch_options.filter = filter;
+        fetch_options.tracer = tracer_ptr;
+        if (filter.since || filter.until) {
+            // anything older than --since could be on a later page, and the first page could be entirely
+            // newer than --until
+            fetch_options.all_pages = true;
+        }
+        if (fetch_options.max_in_flight == 0) {
+            throw std::runtime_error("concurrency must be at least 1");
+        }
+        const long interval = shell_options["interval"].as<long>();
+        if (interval < 1) {
+            throw std::runtime_error("interval must be at least 1 second");
+        }
+
+        ResponseCache cache(shell_options["cache-dir"].as<std::string>());
+        RateLimiter rate_limiter;
+        HttpClientOptions client_options;
+        client_options.rate_limiter = &rate_limiter;
+        client_options.tracer = tracer_ptr;
+        client_options.compression = !shell_options["no-compression"].as<bool>();
+        client_options.http2 = !shell_options["http1.1"].as<bool>();
+        if (shell_options.count("cacert")) {
+            client_options.ca_file = shell_options["cacert"].as<std::string>();
+        }
+        if (!shell_options["no-cache"].as<bool>()) {
+            client_options.cache = &cache;
+        }
 
-        const std::string response_data = get_json_response(endpoint);
-        const std::vector<Event> events = parse_json_response(response_data);
+        if (client_options.cache) {
+            fetch_options.cache = &cache;
+        }
 
-        for (const Event& event : events)
-            std::cout << "- " << event.to_str() << std::endl;
+        HttpClient client(client_options);
+        const bool show_times = shell_options["times"].as<bool>();
+        append_stream_header(out.buffer(), *format);
+        if (shell_options["watch"].as<bool>()) {
+            if (pipeline_options.stats) {
+                throw std::runtime_error("--stats can't be used with --watch");
+            }
+            watch_user_events(client, fetch_options, usernames, *format, show_times, interval, out);
+        }
+        bool all_ok;
+        if (pipeline_options.workers > 0) {
+            all_ok = pipe_user_events(client, fetch_options, usernames, pipeline_options, out);
+        } else if (pipeline_options.stats) {
+            all_ok = print_user_stats(client, fetch_options, usernames, out);
+        } else {
+            all_ok = print_user_events(client, fetch_options, usernames, *format, show_times, out);
+        }
+        if (!finish_output(out) || !all_ok) {
+            return EXIT_FAILURE;
+        }
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
         std::cout << options.help() << std::endl;
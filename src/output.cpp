@@ -0,0 +1,371 @@
+#include <cerrno>
+#include <charconv>
+
+#include <unistd.h>
+
+#include "event_store.hpp"
+#include "output.hpp"
+#include "timestamp.hpp"
+
+namespace {
+
+template <typename T>
+void append_number(std::string& out, T value) {
+    char digits[24];
+    const auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, result.ptr);
+}
+
+void append_ndjson(std::string& out, const EventView& event, std::string_view user) {
+    auto key = [&out](std::string_view name) {
+        out += ",\"";
+        out += name;
+        out += "\":";
+    };
+    auto optional_number = [&](std::string_view name, const std::optional<int>& value) {
+        if (!value) return;
+        key(name);
+        append_number(out, *value);
+    };
+    auto optional_string = [&](std::string_view name, const std::optional<std::string_view>& value) {
+        if (!value) return;
+        key(name);
+        append_json_string(out, *value);
+    };
+
+    out += "{\"user\":";
+    append_json_string(out, user);
+    key("id");
+    append_number(out, event.id);
+    key("type");
+    append_json_string(out, event.type_str());
+    if (!event.action_str().empty()) {
+        key("action");
+        append_json_string(out, event.action_str());
+    }
+    key("created_at");
+    out += '"';
+    append_timestamp(out, event.time);
+    out += '"';
+    key("repo");
+    append_json_string(out, event.repo_name);
+    optional_number("issue_number", event.issue_number);
+    optional_number("pr_number", event.pr_number);
+    optional_number("commit_count", event.commit_count);
+    optional_string("assignee", event.assignee);
+    optional_string("label", event.label);
+    optional_string("collaborator", event.collaborator);
+    optional_string("pr_title", event.pr_title);
+    if (event.requested_reviewers) {
+        key("requested_reviewers");
+        out += '[';
+        for (size_t i = 0; i < event.reviewer_count(); ++i) {
+            if (i > 0) out += ',';
+            append_json_string(out, event.reviewer(i));
+        }
+        out += ']';
+    }
+    out += "}\n";
+}
+
+// quotes a field only if it has to be (RFC 4180)
+void append_csv_field(std::string& out, std::string_view field) {
+    if (field.find_first_of(",\"\r\n") == std::string_view::npos) {
+        out += field;
+        return;
+    }
+
+    out += '"';
+    for (const char c : field) {
+        if (c == '"') out += '"';
+        out += c;
+    }
+    out += '"';
+}
+
+void append_csv(std::string& out, const EventView& event, std::string_view user) {
+    auto optional_number = [&out](const std::optional<int>& value) {
+        out += ',';
+        if (value) append_number(out, *value);
+    };
+    auto optional_string = [&out](const std::optional<std::string_view>& value) {
+        out += ',';
+        if (value) append_csv_field(out, *value);
+    };
+
+    append_csv_field(out, user);
+    out += ',';
+    append_number(out, event.id);
+    out += ',';
+    append_csv_field(out, event.type_str());
+    out += ',';
+    append_csv_field(out, event.action_str());
+    out += ',';
+    append_timestamp(out, event.time);
+    out += ',';
+    append_csv_field(out, event.repo_name);
+    optional_number(event.issue_number);
+    optional_number(event.pr_number);
+    optional_number(event.commit_count);
+    optional_string(event.assignee);
+    optional_string(event.label);
+    optional_string(event.collaborator);
+    optional_string(event.pr_title);
+    optional_string(event.requested_reviewers);
+    out += '\n';
+}
+
+template <typename T>
+void append_little_endian(std::string& out, T value) {
+    auto bits = static_cast<std::make_unsigned_t<T>>(value);
+    char bytes[sizeof(T)];
+    for (size_t i = 0; i < sizeof(T); ++i) {
+        bytes[i] = (char)(bits & 0xff);
+        bits >>= 8;
+    }
+    out.append(bytes, sizeof(T));
+}
+
+void append_binary_string(std::string& out, std::string_view str) {
+    append_little_endian(out, (std::uint32_t)str.size());
+    out += str;
+}
+
+void append_binary(std::string& out, const EventView& event, std::string_view user) {
+    const size_t start = out.size();
+    append_little_endian(out, std::uint32_t(0));  // the length, filled in at the end
+
+    std::uint16_t present = 0;
+    if (event.issue_number) present |= PackedEvent::HasIssueNumber;
+    if (event.pr_number) present |= PackedEvent::HasPrNumber;
+    if (event.commit_count) present |= PackedEvent::HasCommitCount;
+    if (event.assignee) present |= PackedEvent::HasAssignee;
+    if (event.label) present |= PackedEvent::HasLabel;
+    if (event.collaborator) present |= PackedEvent::HasCollaborator;
+    if (event.pr_title) present |= PackedEvent::HasPrTitle;
+    if (event.requested_reviewers) present |= PackedEvent::HasRequestedReviewers;
+
+    append_little_endian(out, event.id);
+    append_little_endian(out, event.time);
+    append_little_endian(out, (std::uint8_t)event.type);
+    append_little_endian(out, (std::uint8_t)event.action);
+    append_little_endian(out, present);
+    append_little_endian(out, (std::int32_t)event.issue_number.value_or(0));
+    append_little_endian(out, (std::int32_t)event.pr_number.value_or(0));
+    append_little_endian(out, (std::int32_t)event.commit_count.value_or(0));
+
+    append_binary_string(out, user);
+    append_binary_string(out, event.type_str());
+    append_binary_string(out, event.action_str());
+    append_binary_string(out, event.repo_name);
+    append_binary_string(out, event.assignee.value_or(std::string_view()));
+    append_binary_string(out, event.label.value_or(std::string_view()));
+    append_binary_string(out, event.collaborator.value_or(std::string_view()));
+    append_binary_string(out, event.pr_title.value_or(std::string_view()));
+    append_binary_string(out, event.requested_reviewers.value_or(std::string_view()));
+
+    std::uint32_t length = (std::uint32_t)(out.size() - start - sizeof(std::uint32_t));
+    for (size_t i = 0; i < sizeof(length); ++i) {
+        out[start + i] = (char)(length & 0xff);
+        length >>= 8;
+    }
+}
+
+}  // namespace
+
+/**
+ * @brief Appends a string as a quoted JSON string, escaping what JSON requires.
+ */
+void append_json_string(std::string& out, std::string_view str) {
+    static constexpr char hex[] = "0123456789abcdef";
+
+    out += '"';
+    size_t start = 0;  // start of the run of characters that don't need escaping
+    for (size_t i = 0; i < str.size(); ++i) {
+        const unsigned char c = (unsigned char)str[i];
+        if (c >= 0x20 && c != '"' && c != '\\') continue;
+
+        out.append(str, start, i - start);
+        start = i + 1;
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                out += "\\u00";
+                out += hex[c >> 4];
+                out += hex[c & 0xf];
+        }
+    }
+    out.append(str, start, str.size() - start);
+    out += '"';
+}
+
+/**
+ * @brief Reads a --format name: text, ndjson, csv or bin.
+ *
+ * @return  The format, or nothing if the name isn't one.
+ */
+std::optional<OutputFormat> output_format_from_string(std::string_view name) {
+    if (name == "text") return OutputFormat::Text;
+    if (name == "ndjson") return OutputFormat::Ndjson;
+    if (name == "csv") return OutputFormat::Csv;
+    if (name == "bin") return OutputFormat::Binary;
+    return std::nullopt;
+}
+
+/**
+ * @brief Appends what a format's output starts with: the header row for CSV, the magic and version for binary.
+ */
+void append_stream_header(std::string& out, OutputFormat format) {
+    switch (format) {
+        case OutputFormat::Csv:
+            out += "user,id,type,action,created_at,repo,issue_number,pr_number,commit_count,"
+                   "assignee,label,collaborator,pr_title,requested_reviewers\n";
+            break;
+        case OutputFormat::Binary:
+            out.append(BINARY_STREAM_MAGIC, sizeof(BINARY_STREAM_MAGIC));
+            append_little_endian(out, BINARY_STREAM_VERSION);
+            break;
+        case OutputFormat::Text:
+        case OutputFormat::Ndjson:
+            break;
+    }
+}
+
+/**
+ * @brief Appends an event in the given format.
+ *
+ * The fields are written straight from the view, without building a document first.
+ *
+ * @param out         The buffer to append to.
+ * @param format      What to write the event as.
+ * @param event       The event.
+ * @param user        Whose event it is (text output has a header per user instead).
+ * @param show_times  For text, whether to follow the event with how long ago it happened.
+ * @param now         The current time, in seconds since the Unix epoch.
+ */
+void append_event_record(std::string& out, OutputFormat format, const EventView& event, std::string_view user,
+                         bool show_times, std::int64_t now) {
+    switch (format) {
+        case OutputFormat::Text:
+            append_event_line(out, event, show_times, now);
+            break;
+        case OutputFormat::Ndjson:
+            append_ndjson(out, event, user);
+            break;
+        case OutputFormat::Csv:
+            append_csv(out, event, user);
+            break;
+        case OutputFormat::Binary:
+            append_binary(out, event, user);
+            break;
+    }
+}
+
+/**
+ * @brief Appends an event as a line of output, including the newline.
+ *
+ * @param out         The buffer to append to.
+ * @param event       The event.
+ * @param show_times  Whether to follow the event with how long ago it happened.
+ * @param now         The current time, in seconds since the Unix epoch.
+ */
+void append_event_line(std::string& out, const EventView& event, bool show_times, std::int64_t now) {
+    out += "- ";
+    event.append_to(out);
+    if (show_times) {
+        out += " (";
+        append_relative_time(out, now - event.time);
+        out += ')';
+    }
+    out += '\n';
+}
+
+/**
+ * @param fd             Where to write, e.g. STDOUT_FILENO.
+ * @param line_buffered  Whether to write after every line rather than in batches.
+ * @param capacity       How many bytes to buffer before writing them anyway.
+ */
+OutputWriter::OutputWriter(int fd, bool line_buffered, size_t capacity)
+    : fd(fd), line_mode(line_buffered), capacity(capacity) {
+    pending.reserve(capacity);
+}
+
+OutputWriter::~OutputWriter() {
+    flush();
+}
+
+/**
+ * @brief Marks the end of a line appended to buffer(), writing the buffer if it's full or line-buffered.
+ */
+void OutputWriter::end_line() {
+    if (line_mode || pending.size() >= capacity) {
+        flush();
+    }
+}
+
+/**
+ * @brief Writes a block of whole lines after what's buffered, buffering it too if it's small enough.
+ */
+void OutputWriter::write(std::string_view block) {
+    if (!line_mode && pending.size() + block.size() < capacity) {
+        pending.append(block);
+        return;
+    }
+
+    struct iovec parts[2] = {
+        {pending.data(), pending.size()},
+        {const_cast<char*>(block.data()), block.size()}
+    };
+    write_all(parts, 2);
+    pending.clear();
+}
+
+/**
+ * @brief Writes whatever is buffered.
+ *
+ * @return  false if writing failed, now or before.
+ */
+bool OutputWriter::flush() {
+    if (!pending.empty()) {
+        struct iovec part = {pending.data(), pending.size()};
+        write_all(&part, 1);
+        pending.clear();
+    }
+    return !failed;
+}
+
+bool OutputWriter::write_all(struct iovec* parts, int count) {
+    // skip empty parts up front, so a short write can be resumed by advancing through them
+    while (count > 0 && parts->iov_len == 0) {
+        ++parts;
+        --count;
+    }
+
+    while (count > 0 && !failed) {
+        const ssize_t result = ::writev(fd, parts, count);
+        ++calls;
+        if (result < 0) {
+            if (errno == EINTR) continue;
+            failed = true;
+            break;
+        }
+
+        written += (size_t)result;
+        size_t done = (size_t)result;
+        while (count > 0 && done >= parts->iov_len) {
+            done -= parts->iov_len;
+            ++parts;
+            --count;
+        }
+        if (count > 0) {
+            parts->iov_base = static_cast<char*>(parts->iov_base) + done;
+            parts->iov_len -= done;
+        }
+    }
+
+    return !failed;
+}
@@ -1,92 +1,537 @@
+#include <charconv>
+#include <cstdint>
 #include <iostream>
-
-#include <lib/json.hpp>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
 
 #include "event.hpp"
+#include "json_parser.hpp"
 #include "parsing.hpp"
+#include "timestamp.hpp"
+
+using json = ScratchJson;
 
 /**
- * @brief Takes a Github API JSON response and returns a vector of Events containing each event's data.
+ * @brief SAX handler that extracts Events from a Github events response without building a DOM.
  *
- * @param response  The raw JSON response.
- * @return          A vector containing Events.
+ * Only the paths an Event needs are kept (type, created_at, repo.name and a handful of payload
+ * fields). Everything else, like commit objects, PR bodies and user objects, is tokenized and
+ * dropped on the spot, so memory scales with the number of events rather than the payload size.
+ * The strings it's handed are the parser's scratch (see sax_parse_json), so those it keeps are copied.
  */
-std::vector<Event> parse_json_response(const std::string& response) {
-    using json = nlohmann::json;
+class EventSaxHandler : public nlohmann::json_sax<json> {
+public:
+    explicit EventSaxHandler(EventCallback on_event, const EventFilter* filter = nullptr)
+        : on_event(std::move(on_event)), filter((filter && filter->filters_content()) ? filter : nullptr) {}
 
-    std::vector<Event> events;
+    bool null() override { return count_element(); }
+    bool boolean(bool) override { return count_element(); }
+    bool number_float(number_float_t, const string_t&) override { return count_element(); }
+    bool binary(binary_t&) override { return count_element(); }
 
-    if (json::accept(response)) {
-        // valid JSON
-        const json response_json = json::parse(response);
+    bool number_integer(number_integer_t val) override {
+        if (!count_element()) return false;
+        set_number(static_cast<int>(val));
+        return true;
+    }
 
-        if (response_json.contains("status") && response_json["status"] == "404") {
-            // user not found
-            std::cerr << "Error: user not found" << std::endl;
-            return std::vector<Event>();  // return a blank vector
-        } else {
-            for (auto it : response_json) {
-                Event new_event = {
-                    it["type"],
-                    it["created_at"],
-                    it["repo"]["name"],
-                    std::nullopt,
-                    std::nullopt,
-                    std::nullopt,
-                    std::nullopt,
-                    std::nullopt,
-                    std::nullopt,
-                    std::nullopt,
-                    std::nullopt,
-                    std::nullopt
-                };
-
-                // check for optional fields and set them if available
-                if (it["payload"].contains("action")) {
-                    new_event.action = it["payload"]["action"];
-                    if (
-                        std::strcmp(new_event.action.value().c_str(), "assigned") == 0 ||
-                        std::strcmp(new_event.action.value().c_str(), "unassigned") == 0
-                    ) {
-                        new_event.assignee = it["payload"]["assignee"]["login"];
+    bool number_unsigned(number_unsigned_t val) override {
+        if (!count_element()) return false;
+        set_number(static_cast<int>(val));
+        return true;
+    }
+
+    bool string(string_t& val) override {
+        if (!count_element()) return false;
+
+        switch (top()) {
+            case Context::Event:
+                if (field == Field::CreatedAt) {
+                    // read even for rejected events: they still tell when paging can stop
+                    dated = parse_timestamp(val, current.time);
+                    if (!dated) {
+                        // an event that can't be placed in time would end the paging at --since
+                        invalid = "invalid created_at: " + std::string(std::string_view(val));
+                        return false;
                     }
+                    if (!oldest || current.time < *oldest) oldest = current.time;
+                } else if (rejected) {
+                    break;
+                } else if (field == Field::Type) {
+                    current.type = event_type_from_string(val);
+                    if (current.type == EventType::Unknown) current.type_name = std::string_view(val);
+                    if (filter && !filter->accepts_type(current.type)) rejected = true;
+                } else if (field == Field::Id) {
+                    std::from_chars(val.data(), val.data() + val.size(), current.id);
                 }
-                if (it["payload"].contains("issue")) {
-                    new_event.issue_number = it["payload"]["issue"]["number"];
-                }
-                if (it["payload"].contains("member")) {
-                    new_event.collaborator = it["payload"]["member"]["login"];
+                break;
+            case Context::Repo:
+                if (field == Field::Name && !rejected) {
+                    current.repo_name = std::string_view(val);
+                    if (filter && !filter->accepts_repo(current.repo_name)) rejected = true;
                 }
-                if (it["payload"].contains("label")) {
-                    new_event.label = it["payload"]["label"]["name"];
-                }
-                if (it["payload"].contains("pull_request")) {
-                    new_event.pr_title = it["payload"]["pull_request"]["title"];
-                    new_event.pr_number = it["payload"]["pull_request"]["number"];
-                    if (it["payload"]["pull_request"].contains("requested_reviewers")) {
-                        std::vector<std::string> usernames;
-                        const auto& reviewer_objects_json = it["payload"]["pull_request"]["requested_reviewers"];
-
-                        // small performance boost
-                        usernames.reserve(reviewer_objects_json.size());
-
-                        for (const auto& user : reviewer_objects_json) {
-                            usernames.push_back(user["login"]);
-                        }
+                break;
+            case Context::Payload:
+                if (field == Field::Action) {
+                    current.action = event_action_from_string(val);
+                    if (current.action == EventAction::Unknown) current.action_name = std::string_view(val);
+                    if (filter && !filter->accepts_action(current.action, current.action_name)) {
+                        // skip the rest of the payload
+                        rejected = true;
+                        contexts.back() = Context::Skip;
                     }
                 }
-                if (it["payload"].contains("commits")) {
-                    new_event.commit_count = it["payload"]["commits"].size();
-                }
+                break;
+            case Context::Member:
+                if (field == Field::Login) current.collaborator.emplace(val);
+                break;
+            case Context::Label:
+                if (field == Field::Name) current.label.emplace(val);
+                break;
+            case Context::Assignee:
+                if (field == Field::Login) current.assignee.emplace(val);
+                break;
+            case Context::PullRequest:
+                if (field == Field::Title) current.pr_title.emplace(val);
+                break;
+            case Context::Reviewer:
+                if (field == Field::Login) current.requested_reviewers->emplace_back(val);
+                break;
+            case Context::ErrorObject:
+                if (field == Field::Status) not_found = (val == "404");
+                else if (field == Field::Message) error_message = std::string_view(val);
+                break;
+            default:
+                break;
+        }
+
+        return true;
+    }
+
+    bool start_object(std::size_t) override {
+        count_element(true);
 
-                events.push_back(new_event);
+        Context next = Context::Skip;
+        switch (top()) {
+            case Context::None:
+                // a top-level object is an API error, not a list of events
+                next = Context::ErrorObject;
+                break;
+            case Context::Root:
+                current.clear();
+                rejected = false;
+                dated = false;
+                next = Context::Event;
+                break;
+            case Context::Event:
+                if (field == Field::Repo) next = Context::Repo;
+                else if (field == Field::Payload && !rejected) next = Context::Payload;
+                break;
+            case Context::Payload:
+                if (field == Field::Issue) next = Context::Issue;
+                else if (field == Field::Member) next = Context::Member;
+                else if (field == Field::Label) next = Context::Label;
+                else if (field == Field::Assignee) next = Context::Assignee;
+                else if (field == Field::PullRequest) next = Context::PullRequest;
+                break;
+            case Context::Reviewers:
+                next = Context::Reviewer;
+                break;
+            default:
+                break;
+        }
+
+        contexts.push_back(next);
+        return true;
+    }
+
+    bool key(string_t& val) override {
+        field = (top() == Context::Skip) ? Field::None : field_for_key(val);
+        return true;
+    }
+
+    bool end_object() override {
+        const Context finished = top();
+        contexts.pop_back();
+
+        if (finished == Context::Event) {
+            if (!dated) {
+                invalid = "event without created_at";
+                return false;
+            }
+            if (filter && (rejected || !filter->accepts_action(current.action, current.action_name))) {
+                // rejected part way through, or filtered on an action and the event had none
+                return true;
+            }
+            // assignee is only meaningful for (un)assignment actions
+            if (current.assignee.has_value() &&
+                !(current.action == EventAction::Assigned || current.action == EventAction::Unassigned)) {
+                current.assignee = std::nullopt;
             }
+            on_event(current);
+        }
+
+        return true;
+    }
+
+    bool start_array(std::size_t) override {
+        if (!count_element()) return false;
+
+        Context next = Context::Skip;
+        if (top() == Context::None) {
+            next = Context::Root;
+        } else if (top() == Context::Payload && field == Field::Commits) {
+            current.commit_count = 0;
+            next = Context::Commits;
+        } else if (top() == Context::PullRequest && field == Field::RequestedReviewers) {
+            current.requested_reviewers = std::vector<std::string>();
+            next = Context::Reviewers;
+        }
+
+        contexts.push_back(next);
+        return true;
+    }
+
+    bool end_array() override {
+        contexts.pop_back();
+        return true;
+    }
+
+    bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception&) override {
+        return false;
+    }
+
+    bool user_not_found() const { return not_found; }
+    const std::string& message() const { return error_message; }
+    const std::string& invalid_content() const { return invalid; }
+    std::optional<std::int64_t> oldest_time() const { return oldest; }
+
+private:
+    // where the parser currently is in the document
+    enum class Context : std::uint8_t {
+        None, Skip, Root, ErrorObject, Event, Repo, Payload,
+        Issue, Member, Label, Assignee, PullRequest, Reviewers, Reviewer, Commits
+    };
+
+    // keys we care about; anything else maps to None
+    enum class Field : std::uint8_t {
+        None, Id, Type, CreatedAt, Repo, Name, Payload, Action, Issue, Number, Member, Login,
+        Label, Assignee, PullRequest, Title, RequestedReviewers, Commits, Status, Message
+    };
+
+    static Field field_for_key(std::string_view key) {
+        static constexpr std::pair<std::string_view, Field> fields[] = {
+            {"id", Field::Id},
+            {"type", Field::Type},
+            {"created_at", Field::CreatedAt},
+            {"repo", Field::Repo},
+            {"name", Field::Name},
+            {"payload", Field::Payload},
+            {"action", Field::Action},
+            {"issue", Field::Issue},
+            {"number", Field::Number},
+            {"member", Field::Member},
+            {"login", Field::Login},
+            {"label", Field::Label},
+            {"assignee", Field::Assignee},
+            {"pull_request", Field::PullRequest},
+            {"title", Field::Title},
+            {"requested_reviewers", Field::RequestedReviewers},
+            {"commits", Field::Commits},
+            {"status", Field::Status},
+            {"message", Field::Message}
+        };
+
+        for (const auto& [name, field] : fields) {
+            if (name == key) return field;
         }
-    } else {
-        // invalid json, return a blank vector
-        std::cerr << "Error: invalid JSON response" << std::endl;
-        return std::vector<Event>();
+        return Field::None;
+    }
+
+    Context top() const {
+        return contexts.empty() ? Context::None : contexts.back();
+    }
+
+    // every value directly inside payload.commits is one commit, and every one directly inside the top-level
+    // array has to be an event object
+    bool count_element(bool is_object = false) {
+        if (top() == Context::Root && !is_object) {
+            invalid = "array element that isn't an event";
+            return false;
+        }
+        if (top() == Context::Commits) ++*current.commit_count;
+        return true;
+    }
+
+    void set_number(int number) {
+        if (field != Field::Number) return;
+
+        if (top() == Context::Issue) current.issue_number = number;
+        else if (top() == Context::PullRequest) current.pr_number = number;
+    }
+
+    EventCallback on_event;
+    const EventFilter* filter;  // null if it filters nothing but time
+    bool rejected = false;      // the current event failed the filter
+    bool dated = false;         // the current event's created_at was read
+    std::optional<std::int64_t> oldest;  // earliest created_at seen, rejected events included
+    std::vector<Context> contexts;
+    Field field = Field::None;
+    Event current;  // scratch, reused for every event so its strings keep their capacity
+
+    bool not_found = false;
+    std::string error_message;
+    std::string invalid;  // why the handler stopped the parse, if it did
+};
+
+namespace {
+
+/**
+ * @brief Returns why a response the handler saw couldn't be parsed: what was wrong with its events, if the
+ *        JSON itself was fine.
+ */
+std::string parse_error_message(const EventSaxHandler& handler) {
+    return handler.invalid_content().empty() ? "invalid JSON response" : handler.invalid_content();
+}
+
+/**
+ * @brief Returns the error carried by a top-level API error object, or an empty string if the handler saw none.
+ */
+std::string api_error(const EventSaxHandler& handler) {
+    if (handler.user_not_found()) {
+        return "user not found";
+    }
+    // some other API error (rate limiting, bad credentials, etc.), if there's a message
+    return handler.message();
+}
+
+/**
+ * @brief Prints the error carried by a top-level API error object, if the handler saw one.
+ *
+ * @return  false if the response was an API error.
+ */
+bool report_api_error(const EventSaxHandler& handler) {
+    const std::string error = api_error(handler);
+    if (!error.empty()) {
+        std::cerr << "Error: " << error << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+}  // namespace
+
+/**
+ * @brief Takes a Github API JSON response and returns a vector of Events containing each event's data.
+ *
+ * @param response  The raw JSON response.
+ * @return          A vector containing Events.
+ */
+std::vector<Event> parse_json_response(const std::string& response) {
+    std::vector<Event> events;
+
+    if (!parse_json_response(response, [&](const Event& event) { events.push_back(event); })) {
+        return std::vector<Event>();  // return a blank vector
     }
 
     return events;
 }
+
+/**
+ * @brief Takes a Github API JSON response and hands each event in it to a callback, without collecting them.
+ *
+ * @param response  The raw JSON response.
+ * @param on_event  Called with each event, in document order.
+ * @param error     If set, receives the error message instead of it being printed.
+ * @param filter    If set, events it rejects by type, repository or action aren't extracted or handed on.
+ * @return          false if the response was invalid JSON, had an element that isn't an event object or an
+ *                  event without a valid created_at, or was an API error.
+ */
+bool parse_json_response(const std::string& response, const EventCallback& on_event, std::string* error,
+                         const EventFilter* filter) {
+    EventSaxHandler handler(on_event, filter);
+
+    if (!sax_parse_json(response, handler)) {
+        if (error) {
+            *error = parse_error_message(handler);
+        } else {
+            std::cerr << "Error: " << parse_error_message(handler) << std::endl;
+        }
+        return false;
+    }
+
+    if (error) {
+        *error = api_error(handler);
+        return error->empty();
+    }
+    return report_api_error(handler);
+}
+
+/**
+ * @param on_event  Called with each event as soon as it's complete.
+ * @param filter    If set, events it rejects by type, repository or action aren't extracted or handed on.
+ *                  It has to outlive the parser.
+ */
+EventStreamParser::EventStreamParser(EventCallback on_event, const EventFilter* filter)
+    : handler(std::make_unique<EventSaxHandler>(std::move(on_event), filter)) {}
+
+EventStreamParser::~EventStreamParser() = default;
+
+/**
+ * @brief Consumes the next chunk of the response body.
+ *
+ * Chunks may split the document anywhere, including inside strings and escape sequences. Bytes
+ * belonging to the event currently being received are buffered until its closing brace arrives.
+ * The events the chunk completes are then parsed together, in a single run of the JSON parser, and
+ * handed to the callback before this returns; the buffers are reused for the next chunk.
+ *
+ * @param data  The chunk's bytes.
+ * @param size  The number of bytes in the chunk.
+ */
+void EventStreamParser::feed(const char* data, std::size_t size) {
+    const char* const end = data + size;
+    const char* p = data;
+    // start of the run of bytes that belongs to the current element
+    const char* segment = (depth > 0 && !between_elements()) ? p : nullptr;
+
+    while (p < end && state != State::Failed) {
+        if (pending_escape) {
+            // the escaped byte was at the start of this chunk
+            pending_escape = false;
+            ++p;
+            continue;
+        }
+        if (in_string) {
+            // skip ahead to the next byte that can end the string
+            while (p < end && *p != '"' && *p != '\\') ++p;
+            if (p == end) break;
+
+            if (*p == '\\') {
+                if (++p == end) {
+                    pending_escape = true;
+                    break;
+                }
+            } else {
+                in_string = false;
+            }
+            ++p;
+            continue;
+        }
+
+        const char c = *p;
+
+        if (between_elements()) {
+            // only what the whole-page parser would accept here: elements separated by single commas, and
+            // nothing but whitespace after the document
+            if (c == ' ' || c == '\n' || c == '\r' || c == '\t') {
+                // skipped anywhere
+            } else if (c == '{' && (state == State::BeforeDocument ||
+                                    (state == State::InArray && expected != Expected::SeparatorOrEnd))) {
+                if (state == State::BeforeDocument) state = State::InErrorObject;
+                segment = p;
+                ++depth;
+            } else if (c == '[' && state == State::BeforeDocument) {
+                state = State::InArray;
+                expected = Expected::ElementOrEnd;
+                depth = 1;
+            } else if (c == ']' && state == State::InArray && expected != Expected::Element) {
+                state = State::Done;
+                depth = 0;
+            } else if (c == ',' && state == State::InArray && expected == Expected::SeparatorOrEnd) {
+                expected = Expected::Element;
+            } else {
+                state = State::Failed;
+            }
+            ++p;
+            continue;
+        }
+
+        if (c == '"') {
+            in_string = true;
+        } else if (c == '{' || c == '[') {
+            ++depth;
+        } else if (c == '}' || c == ']') {
+            --depth;
+
+            if (between_elements()) {
+                // the current element just closed
+                if (state == State::InErrorObject) {
+                    buffer.append(segment, p + 1);
+                    parse_element();
+                } else {
+                    batch += batch.empty() ? '[' : ',';
+                    batch += buffer;
+                    batch.append(segment, p + 1);
+                    buffer.clear();
+                    expected = Expected::SeparatorOrEnd;
+                }
+                segment = nullptr;
+            }
+        }
+        ++p;
+    }
+
+    if (segment != nullptr && state != State::Failed) {
+        buffer.append(segment, end);
+    }
+    if (!batch.empty()) {
+        parse_batch();
+    }
+}
+
+/**
+ * @brief Signals the end of the response body and reports any error in it.
+ *
+ * @param error  If set, receives the error message instead of it being printed.
+ * @return       true if the whole body was a valid list of events.
+ */
+bool EventStreamParser::finish(std::string* error) {
+    if (state != State::Done) {
+        if (error) {
+            *error = parse_error_message(*handler);
+        } else {
+            std::cerr << "Error: " << parse_error_message(*handler) << std::endl;
+        }
+        return false;
+    }
+
+    if (error) {
+        *error = api_error(*handler);
+        return error->empty();
+    }
+    return report_api_error(*handler);
+}
+
+/**
+ * @brief Returns the earliest creation time of the events parsed so far, including those the filter rejected.
+ */
+std::optional<std::int64_t> EventStreamParser::oldest_time() const {
+    return handler->oldest_time();
+}
+
+// true when the next byte is not part of an element (i.e. between events, or outside the document)
+bool EventStreamParser::between_elements() const {
+    return (state == State::InArray) ? depth == 1 : depth == 0;
+}
+
+// parses the top-level error object
+void EventStreamParser::parse_element() {
+    state = State::Done;
+    if (!sax_parse_json(buffer, *handler)) {
+        state = State::Failed;
+    }
+    buffer.clear();
+}
+
+// parses the events the last chunk completed, as one array
+void EventStreamParser::parse_batch() {
+    batch += ']';
+    if (!sax_parse_json(batch, *handler)) {
+        state = State::Failed;
+    }
+    batch.clear();
+}
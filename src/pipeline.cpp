@@ -0,0 +1,426 @@
+#include <algorithm>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <utility>
+
+#include "output.hpp"
+#include "parsing.hpp"
+#include "pipeline.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * @brief Adds another thread's counts to these.
+ */
+void PipelineStats::merge(const PipelineStats& other) {
+    pages += other.pages;
+    events += other.events;
+    bytes_in += other.bytes_in;
+    bytes_out += other.bytes_out;
+    failed_users += other.failed_users;
+
+    read += other.read;
+    stalled += other.stalled;
+    parse += other.parse;
+    format += other.format;
+    write += other.write;
+
+    input_samples += other.input_samples;
+    input_total += other.input_total;
+    input_max = std::max(input_max, other.input_max);
+    output_samples += other.output_samples;
+    output_total += other.output_total;
+    output_max = std::max(output_max, other.output_max);
+}
+
+/**
+ * @brief Starts the workers and the writer.
+ *
+ * @param usernames  The users whose pages will be submitted, in output order.
+ * @param options    How to run the pipeline.
+ * @param out        Where the writer writes the rendered events.
+ */
+RenderPipeline::RenderPipeline(std::vector<std::string> usernames, PipelineOptions options, OutputWriter& out)
+    : usernames(std::move(usernames)),
+      options(std::move(options)),
+      out(out),
+      print_headers(this->usernames.size() > 1 && this->options.format == OutputFormat::Text && !this->options.stats),
+      input(this->options.queue_capacity),
+      output(this->options.queue_capacity),
+      started(Clock::now()) {
+    const size_t worker_count = std::max<size_t>(this->options.workers, 1);
+
+    worker_stats.resize(worker_count);
+    worker_activity.resize(worker_count);
+    workers_running = worker_count;
+    for (size_t i = 0; i < worker_count; ++i) {
+        workers.emplace_back([this, i] { work(worker_stats[i], worker_activity[i]); });
+    }
+    writer = std::thread([this] { write(); });
+}
+
+RenderPipeline::~RenderPipeline() {
+    if (!finished) {
+        finish();
+    }
+}
+
+/**
+ * @brief Queues a page for parsing, waiting for room if the workers have fallen a whole queue behind.
+ *
+ * Every page of every user has to be submitted (failed ones with `ok` unset), or the writer can't
+ * tell that a user is done until the pipeline is finished.
+ */
+void RenderPipeline::submit(PageJob job) {
+    ++stats.pages;
+    stats.bytes_in += job.body.size();
+
+    if (input.try_push(job)) {
+        return;
+    }
+
+    const Clock::time_point stall_start = Clock::now();
+    Backoff backoff;
+    while (!input.try_push(job)) {
+        backoff.wait();
+    }
+    stats.stalled += Clock::now() - stall_start;
+}
+
+/**
+ * @brief Waits for every submitted page to be written.
+ *
+ * @return  What each stage did, merged over all threads.
+ */
+PipelineStats RenderPipeline::finish() {
+    const Clock::time_point closed = Clock::now();
+    finished = true;
+    input_closed.store(true, std::memory_order_release);
+
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    writer.join();
+
+    PipelineStats total = stats;
+    total.read = (closed - started) - stats.stalled;
+    total.wall = Clock::now() - started;
+    total.workers = workers.size();
+    total.input_capacity = input.max_size();
+    total.output_capacity = output.max_size();
+    for (const PipelineStats& partial : worker_stats) {
+        total.merge(partial);
+    }
+    total.merge(writer_stats);
+
+    return total;
+}
+
+/**
+ * @brief Merges the workers' event counts; only meaningful with `stats` set, once the pipeline is finished.
+ */
+ActivityStats RenderPipeline::activity() const {
+    ActivityStats total;
+    for (const ActivityStats& partial : worker_activity) {
+        total.merge(partial);
+    }
+    return total;
+}
+
+/**
+ * @brief A worker: renders pages off the input queue onto the output queue until the input is closed and empty.
+ */
+void RenderPipeline::work(PipelineStats& stats, ActivityStats& activity) {
+    EventStore events;  // reused for every page, so its buffers only grow to the largest page once
+    PageJob job;
+    RenderedPage rendered;
+    Backoff backoff;
+
+    while (true) {
+        if (!input.try_pop(job)) {
+            if (!input_closed.load(std::memory_order_acquire)) {
+                backoff.wait();
+                continue;
+            }
+            // closed, so anything still queued was pushed before the flag was set
+            if (!input.try_pop(job)) {
+                break;
+            }
+        }
+        backoff.reset();
+
+        const size_t queued = input.size() + 1;
+        ++stats.input_samples;
+        stats.input_total += queued;
+        stats.input_max = std::max(stats.input_max, queued);
+
+        render(job, rendered, events, stats, activity);
+        while (!output.try_push(rendered)) {
+            backoff.wait();
+        }
+        backoff.reset();
+    }
+
+    workers_running.fetch_sub(1, std::memory_order_release);
+}
+
+/**
+ * @brief Parses a page and renders the events that pass the filter, or just counts them with `stats` set.
+ */
+void RenderPipeline::render(PageJob& job, RenderedPage& rendered, EventStore& events, PipelineStats& stats,
+                            ActivityStats& activity) const {
+    rendered.user = job.user;
+    rendered.page = job.page;
+    rendered.page_count = job.page_count;
+    rendered.last = false;
+    rendered.text.clear();
+    rendered.error = job.error;
+    events.clear();
+
+    const Clock::time_point parse_start = Clock::now();
+    rendered.ok = job.ok && parse_json_response(job.body, [&](const Event& event) {
+        if (rendered.last) {
+            return;
+        }
+        if (options.filter.since && event.time < *options.filter.since) {
+            // events come newest first, so nothing after this one is wanted either
+            rendered.last = true;
+            return;
+        }
+        if (!options.filter.accepts_time(event.time)) {
+            return;
+        }
+        events.add(event);
+    }, &rendered.error, &options.filter);
+    const Clock::time_point format_start = Clock::now();
+
+    if (rendered.ok && options.stats) {
+        for (size_t i = 0; i < events.size(); ++i) {
+            activity.add(events[i]);
+        }
+    } else if (rendered.ok) {
+        for (size_t i = 0; i < events.size(); ++i) {
+            append_event_record(rendered.text, options.format, events[i], usernames[job.user], options.show_times,
+                                options.now);
+        }
+    }
+    rendered.events = rendered.ok ? events.size() : 0;
+    const Clock::time_point format_end = Clock::now();
+
+    stats.parse += format_start - parse_start;
+    stats.format += format_end - format_start;
+    stats.events += rendered.events;
+
+    if (options.tracer) {
+        const std::string& username = usernames[job.user];
+        options.tracer->span("parse", parse_start, format_start - parse_start, {
+            {"user", username},
+            {"page", (std::int64_t)job.page + 1},
+            {"bytes", (std::int64_t)job.body.size()},
+            {"events", (std::int64_t)rendered.events},
+        });
+        options.tracer->span("render", format_start, format_end - format_start, {
+            {"user", username},
+            {"page", (std::int64_t)job.page + 1},
+            {"events", (std::int64_t)rendered.events},
+        });
+    }
+}
+
+/**
+ * @brief The writer: writes rendered pages in input order until every user is done.
+ */
+void RenderPipeline::write() {
+    PipelineStats& stats = writer_stats;
+    std::map<std::pair<size_t, size_t>, RenderedPage> pending;  // pages finished out of turn
+    size_t head_user = 0;
+    size_t head_page = 0;
+    bool head_ok = true;
+    std::string head_error;  // what was wrong with the first of the head user's pages that couldn't be read
+    RenderedPage rendered;
+    Backoff backoff;
+
+    auto start_user = [&] {
+        if (print_headers && head_user < usernames.size()) {
+            out.buffer() += usernames[head_user];
+            out.buffer() += ":\n";
+            out.end_line();
+        }
+    };
+    auto finish_user = [&] {
+        if (!head_ok) {
+            // the one report of the failure, with the first reason there was
+            out.flush();
+            std::cerr << "Error: couldn't read events for " << usernames[head_user];
+            if (!head_error.empty()) std::cerr << ": " << head_error;
+            std::cerr << std::endl;
+            ++stats.failed_users;
+        }
+        // drop whatever else of the user's pages came in, e.g. those past a --since cutoff
+        pending.erase(pending.lower_bound({head_user, 0}), pending.lower_bound({head_user + 1, 0}));
+        ++head_user;
+        head_page = 0;
+        head_ok = true;
+        head_error.clear();
+        start_user();
+    };
+    // writes as many of the pending pages as are next in line
+    auto flush = [&] {
+        while (head_user < usernames.size()) {
+            const auto it = pending.find({head_user, head_page});
+            if (it == pending.end()) {
+                return;
+            }
+
+            RenderedPage& page = it->second;
+            bool done = true;
+            if (page.ok) {
+                out.write(page.text);
+                stats.bytes_out += page.text.size();
+                done = page.last || head_page + 1 >= page.page_count;
+            } else {
+                if (head_ok) head_error = page.error;
+                head_ok = false;
+            }
+            pending.erase(it);
+            ++head_page;
+
+            if (done) {
+                finish_user();
+            }
+        }
+    };
+
+    start_user();
+    while (head_user < usernames.size()) {
+        if (!output.try_pop(rendered)) {
+            if (workers_running.load(std::memory_order_acquire) != 0) {
+                backoff.wait();
+                continue;
+            }
+            if (!output.try_pop(rendered)) {
+                break;
+            }
+        }
+        backoff.reset();
+
+        const size_t queued = output.size() + 1;
+        ++stats.output_samples;
+        stats.output_total += queued;
+        stats.output_max = std::max(stats.output_max, queued);
+
+        if (rendered.user < head_user) {
+            // the user was already cut off
+            continue;
+        }
+        const Clock::time_point write_start = Clock::now();
+        const std::pair<size_t, size_t> key(rendered.user, rendered.page);
+        pending.insert_or_assign(key, std::move(rendered));
+        flush();
+        stats.write += Clock::now() - write_start;
+    }
+
+    // everything has been rendered, so any user still left is missing a page
+    const Clock::time_point write_start = Clock::now();
+    while (head_user < usernames.size()) {
+        flush();
+        if (head_user < usernames.size()) {
+            head_ok = false;
+            finish_user();
+        }
+    }
+    out.flush();
+    stats.write += Clock::now() - write_start;
+}
+
+/**
+ * @brief Fetches every user's pages and submits each response body to a pipeline once it's complete.
+ *
+ * Meant to run on the thread that called it, as the pipeline's producer: this thread only drives the
+ * sockets, while the pipeline's threads do the parsing, formatting and writing. Unlike EventFetcher,
+ * pages aren't parsed as they stream in, so there's no binary event cache and no early --since cutoff.
+ *
+ * @param client     The client to send the requests with.
+ * @param options    How to fetch the events (the time window and cache are left to the pipeline and client).
+ * @param usernames  The users to fetch events for, in the order the pipeline was given them.
+ * @param pipeline   Receives every page.
+ */
+void fetch_into_pipeline(HttpClient& client, const FetchOptions& options, const std::vector<std::string>& usernames,
+                         RenderPipeline& pipeline) {
+    std::deque<HttpRequest> requests;
+    std::deque<PageJob> jobs;  // a deque, so the bodies being received stay put as more pages are queued
+    std::vector<size_t> page_counts(usernames.size(), 1);
+
+    std::function<void(size_t, size_t)> queue_page = [&](size_t user, size_t page) {
+        std::string endpoint = options.api_url + "/users/" + usernames[user] + "/events";
+        if (options.all_pages) {
+            endpoint += "?per_page=" + std::to_string(EventFetcher::per_page) + "&page=" + std::to_string(page + 1);
+        }
+
+        jobs.push_back(PageJob());
+        PageJob& job = jobs.back();
+        job.user = user;
+        job.page = page;
+
+        requests.push_back({
+            std::move(endpoint),
+            [&job](const char* data, size_t size) { job.body.append(data, size); },
+            [&, user](const HttpResult& result) {
+                job.ok = result.ok;
+                job.error = result.error;
+                job.page_count = page_counts[user];
+                pipeline.submit(std::move(job));
+            },
+            nullptr,
+            nullptr
+        });
+        // users are written in input order, so an earlier user's later pages go before a later user's first
+        requests.back().priority = -(int)user;
+
+        if (options.all_pages && page == 0) {
+            requests.back().on_header = [&, user](std::string_view name, std::string_view value) {
+                if (name != "link") return;
+
+                const size_t last_page = std::min(last_page_from_link_header(value), EventFetcher::max_pages);
+                while (page_counts[user] < last_page) {
+                    queue_page(user, page_counts[user]++);
+                }
+            };
+        }
+    };
+
+    for (size_t user = 0; user < usernames.size(); ++user) {
+        queue_page(user, 0);
+    }
+    client.get_all(requests, options.max_in_flight);
+}
+
+/**
+ * @brief Prints what each stage of a pipeline run did to stderr.
+ */
+void print_pipeline_stats(const PipelineStats& stats) {
+    auto ms = [](std::chrono::nanoseconds time) { return std::chrono::duration<double, std::milli>(time).count(); };
+    auto per_second = [&](double count, std::chrono::nanoseconds time) {
+        return (time.count() > 0) ? count / std::chrono::duration<double>(time).count() : 0.0;
+    };
+    auto average = [](size_t total, size_t samples) { return (samples > 0) ? (double)total / (double)samples : 0.0; };
+
+    std::fprintf(stderr, "pipeline: %zu pages, %zu events, %zu bytes in, %zu bytes out, %zu workers, %.2f ms\n",
+                 stats.pages, stats.events, stats.bytes_in, stats.bytes_out, stats.workers, ms(stats.wall));
+    std::fprintf(stderr, "  read    %10.2f ms  %12.0f pages/s  (stalled on a full queue %.2f ms)\n",
+                 ms(stats.read), per_second((double)stats.pages, stats.read), ms(stats.stalled));
+    std::fprintf(stderr, "  parse   %10.2f ms  %12.0f events/s per worker  %8.1f MB/s per worker\n",
+                 ms(stats.parse), per_second((double)stats.events, stats.parse),
+                 per_second((double)stats.bytes_in, stats.parse) / 1e6);
+    std::fprintf(stderr, "  format  %10.2f ms  %12.0f events/s per worker\n",
+                 ms(stats.format), per_second((double)stats.events, stats.format));
+    std::fprintf(stderr, "  write   %10.2f ms  %12.0f events/s\n",
+                 ms(stats.write), per_second((double)stats.events, stats.write));
+    std::fprintf(stderr, "  input queue   %6.1f avg  %4zu max  of %zu\n",
+                 average(stats.input_total, stats.input_samples), stats.input_max, stats.input_capacity);
+    std::fprintf(stderr, "  output queue  %6.1f avg  %4zu max  of %zu\n",
+                 average(stats.output_total, stats.output_samples), stats.output_max, stats.output_capacity);
+}
@@ -0,0 +1,115 @@
+#include <algorithm>
+#include <ctime>
+
+#include "rate_limiter.hpp"
+
+// the backoff for the first retry, doubled for every one after it
+static const std::chrono::milliseconds BASE_BACKOFF(1000);
+static const std::chrono::milliseconds MAX_BACKOFF(60000);
+
+RateLimiter::RateLimiter() : last_refill(Clock::now()), rng(std::random_device()()) {}
+
+/**
+ * @brief Takes a token if one is available.
+ *
+ * @param now  The current time.
+ * @return     Whether a request may start now.
+ */
+bool RateLimiter::try_acquire(Clock::time_point now) {
+    if (now < paused_until) {
+        return false;
+    }
+    if (!limited) {
+        return true;
+    }
+
+    refill(now);
+    if (tokens < 1) {
+        return false;
+    }
+    tokens -= 1;
+    return true;
+}
+
+/**
+ * @brief Returns how long it will be until try_acquire can succeed.
+ */
+RateLimiter::Clock::duration RateLimiter::time_until_token(Clock::time_point now) const {
+    Clock::duration wait = std::max(paused_until - now, Clock::duration::zero());
+
+    if (limited) {
+        const double missing = 1 - tokens;
+        if (missing > 0) {
+            Clock::duration refilled = window_reset - now;
+            if (rate > 0) {
+                refilled = std::min(refilled, std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(missing / rate)));
+            }
+            wait = std::max(wait, refilled);
+        }
+    }
+
+    return wait;
+}
+
+/**
+ * @brief Adjusts the bucket to what a response said about the quota.
+ *
+ * @param remaining  X-RateLimit-Remaining: requests left in the current window.
+ * @param reset      X-RateLimit-Reset: when the window ends, in seconds since the Unix epoch.
+ */
+void RateLimiter::update(std::int64_t remaining, std::int64_t reset) {
+    const Clock::time_point now = Clock::now();
+    refill(now);
+
+    const std::int64_t until_reset = std::max<std::int64_t>(reset - std::time(nullptr), 1);
+
+    limited = true;
+    window_reset = now + std::chrono::seconds(until_reset);
+    rate = (double)std::max<std::int64_t>(remaining, 0) / (double)until_reset;
+    capacity = std::clamp((double)remaining, 1.0, burst);
+    // requests the server already counted can't be spent again
+    tokens = std::min(tokens, (double)remaining);
+
+    if (remaining <= 0) {
+        // nothing left: wait for the window to reset
+        paused_until = std::max(paused_until, window_reset);
+    }
+}
+
+/**
+ * @brief Pauses every request after a rate-limit error.
+ *
+ * @param attempt      How many times the failed request has been retried already.
+ * @param retry_after  The response's Retry-After, in seconds, if it had one.
+ * @return             How long the request should wait before it's retried.
+ */
+RateLimiter::Clock::duration RateLimiter::back_off(int attempt, std::optional<std::int64_t> retry_after) {
+    const Clock::time_point now = Clock::now();
+    Clock::duration delay;
+
+    if (retry_after) {
+        delay = std::chrono::seconds(std::max<std::int64_t>(*retry_after, 0));
+    } else {
+        // "equal jitter": half of the exponential backoff, plus up to as much again at random
+        const std::chrono::milliseconds backoff = std::min(BASE_BACKOFF * (1 << std::min(attempt, 16)), MAX_BACKOFF);
+        std::uniform_int_distribution<long> jitter(0, backoff.count() / 2);
+        delay = backoff / 2 + std::chrono::milliseconds(jitter(rng));
+    }
+
+    // a pause set by update() for an exhausted quota may be longer
+    paused_until = std::max(paused_until, now + delay);
+    return paused_until - now;
+}
+
+void RateLimiter::refill(Clock::time_point now) {
+    if (now >= window_reset) {
+        // a new window: the quota is unknown again until a response says what it is
+        limited = false;
+        tokens = capacity = burst;
+        rate = 0;
+    }
+
+    const double elapsed = std::chrono::duration<double>(now - last_refill).count();
+    last_refill = now;
+    tokens = std::min(capacity, tokens + elapsed * rate);
+}
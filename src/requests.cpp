@@ -1,58 +1,670 @@
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
 #include <cstdlib>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <iostream>
+#include <thread>
+#include <vector>
 
 #include <curl/curl.h>
 
+#include "requests.hpp"
+
+/**
+ * @brief State of one request while it's being performed.
+ */
+struct HttpClient::Transfer {
+    HttpRequest* request = nullptr;
+    struct curl_slist* headers = nullptr;  // base headers plus conditional ones, if any
+    std::optional<CachedResponse> cached;  // what the request is conditional on
+    CachedResponse received;               // validators and body to cache from a 200
+    bool caching = false;
+
+    long status = 0;  // of the response being received
+    std::optional<std::int64_t> rate_limit_remaining;
+    std::optional<std::int64_t> rate_limit_reset;
+    std::optional<std::int64_t> retry_after;
+    int attempt = 0;         // retries of the request so far
+    size_t order = 0;        // position of the request in get_all's queue
+    bool retryable = false;  // a rate-limit error would be retried, so its response isn't passed on
+    Tracer::Clock::time_point started;  // when the handle was set up, with a tracer
+    size_t body_bytes = 0;              // of the response, decoded
+    std::string content_encoding;       // of the response, if it was compressed
+    // a retryable 403's headers, held back until the last of them tells whether it's a rate limit
+    std::vector<std::pair<std::string, std::string>> held_headers;
+
+    // 403 with no quota left or a Retry-After, or 429: the primary or a secondary rate limit was hit
+    bool rate_limited() const {
+        return status == 429 || (status == 403 && (retry_after || rate_limit_remaining == 0));
+    }
+};
+
+/**
+ * @brief Reads a header value that's a plain integer.
+ */
+static std::optional<std::int64_t> parse_integer(std::string_view value) {
+    std::int64_t number = 0;
+    const auto result = std::from_chars(value.data(), value.data() + value.size(), number);
+    if (result.ec != std::errc() || result.ptr != value.data() + value.size()) {
+        return std::nullopt;
+    }
+    return number;
+}
+
+/**
+ * @brief Names a CURLINFO_HTTP_VERSION value the way the status line would.
+ */
+static std::string_view http_version_name(long version) {
+    switch (version) {
+        case CURL_HTTP_VERSION_1_0: return "1.0";
+        case CURL_HTTP_VERSION_1_1: return "1.1";
+        case CURL_HTTP_VERSION_2_0: return "2";
+        case CURL_HTTP_VERSION_3: return "3";
+        default: return "none";
+    }
+}
+
 /**
  * @brief Callback that handles HTTP response data.
  *
  * @param contents  The HTTP response data.
  * @param size      The size of each data element (usually 1 byte).
  * @param nmemb     The number of data elements received.
- * @param userp     Points to the location where the response data will be stored.
- * @return          The number of bytes stored at userp.
+ * @param userp     Points to the Transfer the response belongs to.
+ * @return          The number of bytes consumed (0 aborts the transfer).
  */
-size_t write_callback(void* contents, size_t size, size_t nmemb, void* userp) {
-    ((std::string*)userp)->append((char*)contents, size * nmemb);
+size_t HttpClient::write_callback(void* contents, size_t size, size_t nmemb, void* userp) {
+    auto* transfer = (Transfer*)userp;
+    if (transfer->request->cancelled) {
+        return 0;
+    }
+    if (transfer->retryable && transfer->rate_limited()) {
+        // the error body isn't the response the request is waiting for
+        return size * nmemb;
+    }
+
+    transfer->body_bytes += size * nmemb;
+    if (transfer->caching) {
+        transfer->received.body.append((const char*)contents, size * nmemb);
+    }
+    transfer->request->on_data((const char*)contents, size * nmemb);
     return size * nmemb;
 }
 
 /**
- * @brief Builds and sends a GET request to the given API endpoint and returns JSON response data.
+ * @brief Callback that handles HTTP response headers, one line at a time.
+ *
+ * @param buffer    The header line, including its trailing CRLF.
+ * @param size      Always 1.
+ * @param nitems    The length of the header line.
+ * @param userp     Points to the Transfer the response belongs to.
+ * @return          The number of bytes consumed.
+ */
+size_t HttpClient::header_callback(char* buffer, size_t size, size_t nitems, void* userp) {
+    auto* transfer = (Transfer*)userp;
+    const std::string_view line(buffer, size * nitems);
+    const size_t colon = line.find(':');
+
+    // status lines and the blank line that ends the headers have no colon
+    if (colon == std::string_view::npos) {
+        if (line.starts_with("HTTP/")) {
+            // a new response starts (a redirect was followed or there was an interim response)
+            const size_t space = line.find(' ');
+            transfer->status = 0;
+            if (space != std::string_view::npos) {
+                transfer->status = parse_integer(line.substr(space + 1, 3)).value_or(0);
+            }
+            transfer->rate_limit_remaining.reset();
+            transfer->rate_limit_reset.reset();
+            transfer->retry_after.reset();
+            transfer->content_encoding.clear();
+            transfer->held_headers.clear();
+        } else if (!transfer->held_headers.empty()) {
+            // the end of a 403's headers: a plain one is the response, so its headers are passed on after all
+            if (!transfer->rate_limited()) {
+                for (const auto& [held_name, held_value] : transfer->held_headers) {
+                    transfer->request->on_header(held_name, held_value);
+                }
+            }
+            transfer->held_headers.clear();
+        }
+        return size * nitems;
+    }
+
+    std::string name(line.substr(0, colon));
+    for (char& c : name) {
+        c = (char)std::tolower((unsigned char)c);
+    }
+
+    std::string_view value = line.substr(colon + 1);
+    const size_t first = value.find_first_not_of(" \t");
+    const size_t last = value.find_last_not_of(" \t\r\n");
+    value = (first == std::string_view::npos) ? std::string_view() : value.substr(first, last - first + 1);
+
+    if (transfer->caching) {
+        if (name == "etag") transfer->received.etag = value;
+        else if (name == "last-modified") transfer->received.last_modified = value;
+        else if (name == "link") transfer->received.link = value;
+    }
+    if (name == "x-ratelimit-remaining") transfer->rate_limit_remaining = parse_integer(value);
+    else if (name == "x-ratelimit-reset") transfer->rate_limit_reset = parse_integer(value);
+    else if (name == "retry-after") transfer->retry_after = parse_integer(value);
+    else if (name == "content-encoding") transfer->content_encoding = value;
+
+    if (transfer->request->on_header) {
+        if (transfer->retryable && transfer->status == 429) {
+            // a rate-limit error that will be retried, so these aren't the response's headers
+        } else if (transfer->retryable && transfer->status == 403) {
+            // only a rate limit if a later header says so
+            transfer->held_headers.emplace_back(std::move(name), value);
+        } else {
+            transfer->request->on_header(name, value);
+        }
+    }
+
+    return size * nitems;
+}
+
+HttpClient::HttpClient(HttpClientOptions options) : options(std::move(options)) {
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+
+    headers = curl_slist_append(headers, "accept: application/vnd.github+json");
+    headers = curl_slist_append(headers, "User-Agent: curl/8.6.0");
+
+    if (this->options.reuse_connections) {
+        share = curl_share_init();
+        curl_share_setopt(share, CURLSHOPT_LOCKFUNC, lock_share);
+        curl_share_setopt(share, CURLSHOPT_UNLOCKFUNC, unlock_share);
+        curl_share_setopt(share, CURLSHOPT_USERDATA, this);
+        curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+        curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+    }
+
+    multi = curl_multi_init();
+    curl_multi_setopt(multi, CURLMOPT_PIPELINING, this->options.http2 ? CURLPIPE_MULTIPLEX : CURLPIPE_NOTHING);
+}
+
+HttpClient::~HttpClient() {
+    // handles have to go before the share they're attached to
+    for (CURL* curl : idle_handles) {
+        curl_easy_cleanup(curl);
+    }
+    if (multi) {
+        curl_multi_cleanup(multi);
+    }
+    if (share) {
+        curl_share_cleanup(share);
+    }
+    curl_slist_free_all(headers);
+
+    curl_global_cleanup();
+}
+
+/**
+ * @brief Sends a GET request to the given API endpoint, passing the response body on as it arrives.
  *
  * @param endpoint  The API endpoint to make a request to.
- * @return          The response body (in JSON);
+ * @param on_data   Called with each chunk of the response body as soon as libcurl receives it.
+ * @return          Whether the transfer completed.
  */
-std::string get_json_response(const std::string& endpoint) {
-    CURL* curl;
-    CURLcode response;
-    std::string read_buffer;
-    
-    curl = curl_easy_init();
+bool HttpClient::get(const std::string& endpoint, DataCallback on_data) {
+    HttpRequest request = {endpoint, std::move(on_data), nullptr, nullptr, nullptr};
+    const HttpResult result = get(request);
+    if (!result.ok) {
+        std::cerr << "Request to " << endpoint << " failed: " << result.error << std::endl;
+    }
+    return result.ok;
+}
+
+/**
+ * @brief Runs a single request to completion, blocking until it's done.
+ *
+ * With a rate limiter, the request waits for a token first and is retried after a rate-limit error.
+ *
+ * @param request  The request to run. Its completion callback, if any, is called before returning.
+ * @return         The outcome of the transfer.
+ */
+HttpResult HttpClient::get(HttpRequest& request) {
+    for (int attempt = 0;; ++attempt) {
+        if (options.rate_limiter) {
+            RateLimiter::Clock::time_point now = RateLimiter::Clock::now();
+            while (!options.rate_limiter->try_acquire(now)) {
+                std::this_thread::sleep_for(options.rate_limiter->time_until_token(now));
+                now = RateLimiter::Clock::now();
+            }
+        }
+
+        CURL* curl = acquire_handle();
+        if (!curl) {
+            HttpResult result;
+            result.error = curl_easy_strerror(CURLE_FAILED_INIT);
+            if (request.on_complete) request.on_complete(result);
+            return result;
+        }
+
+        prepare_handle(curl, request, attempt);
+        const CURLcode response = curl_easy_perform(curl);
+
+        const std::optional<RateLimiter::Clock::duration> retry_delay = check_rate_limit(curl, response);
+        if (!retry_delay) {
+            return finish_handle(curl, response);
+        }
+        std::this_thread::sleep_for(*retry_delay);
+    }
+}
+
+/**
+ * @brief Runs many GET requests concurrently through one curl_multi event loop.
+ *
+ * At most max_in_flight transfers run at once; as soon as one finishes, its completion callback is
+ * called and the next queued request takes its slot. Queued requests start by priority, then in
+ * order, and callbacks may append more requests to the queue while it runs. Cancelled requests are
+ * skipped. With a rate limiter, requests also wait for a token, and ones that hit a rate limit are
+ * queued again to be retried after a backoff.
+ *
+ * @param requests       The queue of requests to run.
+ * @param max_in_flight  The maximum number of concurrent transfers.
+ */
+void HttpClient::get_all(std::deque<HttpRequest>& requests, size_t max_in_flight) {
+    using Clock = RateLimiter::Clock;
+
+    struct Queued {
+        HttpRequest* request;
+        size_t order;
+        int attempt;
+        Clock::time_point not_before;  // when a retry may start
+    };
+
+    std::vector<Queued> queued;
+    size_t next_request = 0;
+    size_t in_flight = 0;
+
+    // starts queued requests until the window is full, returns how long until the next one could start
+    auto fill_window = [&]() -> Clock::duration {
+        for (; next_request < requests.size(); ++next_request) {
+            queued.push_back({&requests[next_request], next_request, 0, Clock::time_point()});
+        }
+        std::erase_if(queued, [](const Queued& entry) { return entry.request->cancelled; });
+
+        while (in_flight < max_in_flight && !queued.empty()) {
+            const Clock::time_point now = Clock::now();
+
+            auto next = queued.end();
+            Clock::time_point earliest = Clock::time_point::max();
+            for (auto it = queued.begin(); it != queued.end(); ++it) {
+                if (it->not_before > now) {
+                    earliest = std::min(earliest, it->not_before);
+                } else if (next == queued.end() || it->request->priority > next->request->priority ||
+                           (it->request->priority == next->request->priority && it->order < next->order)) {
+                    next = it;
+                }
+            }
+            if (next == queued.end()) {
+                return earliest - now;
+            }
+            if (options.rate_limiter && !options.rate_limiter->try_acquire(now)) {
+                return options.rate_limiter->time_until_token(now);
+            }
+
+            const Queued entry = *next;
+            queued.erase(next);
+
+            CURL* curl = acquire_handle();
+            if (!curl) {
+                HttpResult result;
+                result.error = curl_easy_strerror(CURLE_FAILED_INIT);
+                if (entry.request->on_complete) entry.request->on_complete(result);
+                continue;
+            }
+
+            prepare_handle(curl, *entry.request, entry.attempt)->order = entry.order;
+            curl_multi_add_handle(multi, curl);
+            ++in_flight;
+        }
+
+        return Clock::duration::max();
+    };
+
+    Clock::duration wait = fill_window();
+
+    while (in_flight > 0 || !queued.empty()) {
+        int running = 0;
+        curl_multi_perform(multi, &running);
+
+        CURLMsg* message;
+        int messages_left = 0;
+        while ((message = curl_multi_info_read(multi, &messages_left))) {
+            if (message->msg != CURLMSG_DONE) continue;
+
+            CURL* curl = message->easy_handle;
+            const CURLcode response = message->data.result;
+
+            curl_multi_remove_handle(multi, curl);
+            --in_flight;
+
+            Transfer* transfer = nullptr;
+            curl_easy_getinfo(curl, CURLINFO_PRIVATE, (char**)&transfer);
+            HttpRequest* request = transfer->request;
+            const size_t order = transfer->order;
+            const int attempt = transfer->attempt;
+
+            if (const std::optional<Clock::duration> retry_delay = check_rate_limit(curl, response)) {
+                queued.push_back({request, order, attempt + 1, Clock::now() + *retry_delay});
+            } else {
+                finish_handle(curl, response);
+            }
+        }
+
+        wait = fill_window();
+
+        if (in_flight > 0 || !queued.empty()) {
+            // round up, so a retry or token isn't missed by a hair
+            const Clock::duration timeout = std::min<Clock::duration>(wait, std::chrono::seconds(1));
+            const long timeout_ms = (long)std::chrono::ceil<std::chrono::milliseconds>(timeout).count();
+            curl_multi_poll(multi, nullptr, 0, timeout_ms, nullptr);
+        }
+    }
+}
+
+/**
+ * @brief Points a handle at a request before it's performed.
+ *
+ * With a cache, a request for an endpoint that has a cached response is made conditional on it.
+ *
+ * @param curl     The handle.
+ * @param request  The request to perform with it.
+ * @param attempt  How many times the request has been retried already.
+ * @return         The transfer's state, owned by the handle until it's finished.
+ */
+HttpClient::Transfer* HttpClient::prepare_handle(CURL* curl, HttpRequest& request, int attempt) {
+    auto* transfer = new Transfer();
+    transfer->request = &request;
+    transfer->attempt = attempt;
+    transfer->retryable = options.rate_limiter && attempt < RateLimiter::max_retries;
+    if (options.tracer) {
+        transfer->started = Tracer::Clock::now();
+    }
+
+    if (options.cache) {
+        transfer->caching = true;
+        transfer->cached = options.cache->load(request.endpoint, false);
+    }
+    if (transfer->cached) {
+        for (const curl_slist* header = headers; header; header = header->next) {
+            transfer->headers = curl_slist_append(transfer->headers, header->data);
+        }
+        if (!transfer->cached->etag.empty()) {
+            transfer->headers = curl_slist_append(transfer->headers, ("If-None-Match: " + transfer->cached->etag).c_str());
+        }
+        if (!transfer->cached->last_modified.empty()) {
+            transfer->headers = curl_slist_append(transfer->headers, ("If-Modified-Since: " + transfer->cached->last_modified).c_str());
+        }
+    }
+
+    // headers
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, transfer->headers ? transfer->headers : headers);
+    // API endpoint
+    curl_easy_setopt(curl, CURLOPT_URL, request.endpoint.c_str());
+    // pointer passed to write_callback and header_callback
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, transfer);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, transfer);
+    curl_easy_setopt(curl, CURLOPT_PRIVATE, transfer);
+
+    return transfer;
+}
+
+/**
+ * @brief Feeds a performed handle's rate-limit headers to the rate limiter and checks whether it hit the limit.
+ *
+ * A request that hit the limit and may still be retried is cleaned up here (its handle goes back to the
+ * pool) instead of being finished.
+ *
+ * @return  How long to wait before retrying the request, or nothing if it should be finished as usual.
+ */
+std::optional<RateLimiter::Clock::duration> HttpClient::check_rate_limit(CURL* curl, CURLcode response) {
+    if (!options.rate_limiter) {
+        return std::nullopt;
+    }
+
+    Transfer* transfer = nullptr;
+    curl_easy_getinfo(curl, CURLINFO_PRIVATE, (char**)&transfer);
+
+    if (transfer->rate_limit_remaining && transfer->rate_limit_reset) {
+        options.rate_limiter->update(*transfer->rate_limit_remaining, *transfer->rate_limit_reset);
+    }
+    if (response != CURLE_OK || !transfer->retryable || !transfer->rate_limited() || transfer->request->cancelled) {
+        return std::nullopt;
+    }
+
+    const RateLimiter::Clock::duration delay = options.rate_limiter->back_off(transfer->attempt, transfer->retry_after);
+    std::cerr << "Rate limited, retrying " << transfer->request->endpoint << " in "
+              << std::chrono::duration_cast<std::chrono::seconds>(delay).count() << "s" << std::endl;
+
+    if (options.tracer) {
+        trace_transfer(curl, response);
+    }
+    release_handle(curl);
+    curl_slist_free_all(transfer->headers);
+    delete transfer;
+
+    return delay;
+}
+
+/**
+ * @brief Records a performed handle's transfer: libcurl's timings for each of its phases, and what it received.
+ *
+ * The phase timings are libcurl's, in microseconds from the start of the transfer to the end of the
+ * DNS lookup, the TCP connect, the TLS handshake and the first byte of the response. On a reused
+ * connection the first three are (close to) 0, and new_connections, how many connections the transfer
+ * had to open, is 0. transfer_us is the time from the first byte to the
+ * last. wire_bytes is the body as it was sent (compressed, if it was), body_bytes what it decoded to.
+ */
+void HttpClient::trace_transfer(CURL* curl, CURLcode response) {
+    Transfer* transfer = nullptr;
+    curl_easy_getinfo(curl, CURLINFO_PRIVATE, (char**)&transfer);
+
+    long status = 0, http_version = 0, new_connections = 0;
+    curl_off_t namelookup = 0, connect = 0, appconnect = 0, starttransfer = 0, total = 0, wire_bytes = 0;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status);
+    curl_easy_getinfo(curl, CURLINFO_HTTP_VERSION, &http_version);
+    curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &new_connections);
+    curl_easy_getinfo(curl, CURLINFO_NAMELOOKUP_TIME_T, &namelookup);
+    curl_easy_getinfo(curl, CURLINFO_CONNECT_TIME_T, &connect);
+    curl_easy_getinfo(curl, CURLINFO_APPCONNECT_TIME_T, &appconnect);
+    curl_easy_getinfo(curl, CURLINFO_STARTTRANSFER_TIME_T, &starttransfer);
+    curl_easy_getinfo(curl, CURLINFO_TOTAL_TIME_T, &total);
+    curl_easy_getinfo(curl, CURLINFO_SIZE_DOWNLOAD_T, &wire_bytes);
+
+    options.tracer->async_span("request", transfer->started, std::chrono::microseconds(total), {
+        {"url", transfer->request->endpoint},
+        {"status", (std::int64_t)status},
+        {"result", curl_easy_strerror(response)},
+        {"attempt", (std::int64_t)transfer->attempt},
+        {"http_version", http_version_name(http_version)},
+        {"new_connections", (std::int64_t)new_connections},
+        {"namelookup_us", (std::int64_t)namelookup},
+        {"connect_us", (std::int64_t)connect},
+        {"appconnect_us", (std::int64_t)appconnect},
+        {"starttransfer_us", (std::int64_t)starttransfer},
+        {"total_us", (std::int64_t)total},
+        {"transfer_us", (std::int64_t)(total - starttransfer)},
+        {"encoding", transfer->content_encoding.empty() ? std::string_view("identity") : transfer->content_encoding},
+        {"wire_bytes", (std::int64_t)wire_bytes},
+        {"body_bytes", (std::int64_t)transfer->body_bytes},
+    });
+}
+
+/**
+ * @brief Collects the outcome of a performed handle, returns the handle to the pool and completes the request.
+ *
+ * A 304 replays the cached response (body, and its Link header if the 304 didn't repeat it) to the
+ * request's callbacks, so callers see the same data as for a 200, unless on_not_modified takes care
+ * of it. A 200 refreshes the cache.
+ *
+ * @return  The outcome of the transfer.
+ */
+HttpResult HttpClient::finish_handle(CURL* curl, CURLcode response) {
+    Transfer* transfer = nullptr;
+    curl_easy_getinfo(curl, CURLINFO_PRIVATE, (char**)&transfer);
+    HttpRequest& request = *transfer->request;
+
+    HttpResult result;
+    result.ok = (response == CURLE_OK);
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &result.status);
+
+    if (options.tracer) {
+        trace_transfer(curl, response);
+    }
+    release_handle(curl);
+
+    // left for whoever made the request to report, knowing what it was for
+    if (response != CURLE_OK) {
+        result.error = curl_easy_strerror(response);
+    }
+
+    if (result.ok && result.status == 304 && transfer->cached) {
+        result.from_cache = true;
+        if (request.on_header && transfer->received.link.empty() && !transfer->cached->link.empty()) {
+            request.on_header("link", transfer->cached->link);
+        }
+
+        if (!request.on_not_modified || !request.on_not_modified(*transfer->cached)) {
+            const std::optional<CachedResponse> cached = options.cache->load(request.endpoint);
+            if (cached) {
+                request.on_data(cached->body.data(), cached->body.size());
+            } else {
+                // the entry vanished since the request was made
+                result.ok = false;
+            }
+        }
+    } else if (result.ok && result.status == 200 && transfer->caching &&
+               (!transfer->received.etag.empty() || !transfer->received.last_modified.empty())) {
+        options.cache->store(request.endpoint, transfer->received);
+    }
+
+    curl_slist_free_all(transfer->headers);
+    delete transfer;
+
+    if (request.on_complete) {
+        request.on_complete(result);
+    }
+
+    return result;
+}
+
+/**
+ * @brief Takes an idle easy handle from the pool, or creates and configures a new one.
+ *
+ * @return  A handle ready for a request, or nullptr if libcurl couldn't create one.
+ */
+CURL* HttpClient::acquire_handle() {
+    {
+        std::lock_guard<std::mutex> lock(pool_mutex);
+        if (!idle_handles.empty()) {
+            CURL* curl = idle_handles.back();
+            idle_handles.pop_back();
+            return curl;
+        }
+    }
+
+    CURL* curl = curl_easy_init();
     if (curl) {
-        struct curl_slist *headers = NULL;
-        headers = curl_slist_append(headers, "accept: application/vnd.github+json");
-        headers = curl_slist_append(headers, "User-Agent: curl/8.6.0");
-
-        // headers
-        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-        // API endpoint
-        curl_easy_setopt(curl, CURLOPT_URL, endpoint.c_str());
-        // set callback for writing response data
+        // set callbacks for handling response data and headers
         curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
-        // pointer passed to write_callback, points to buffer for data to
-        // be written to
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &read_buffer);
+        curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, header_callback);
 
-        response = curl_easy_perform(curl);
+        if (options.http2) {
+            // h2 where the server offers it in the TLS handshake, HTTP/1.1 otherwise (and for plain http)
+            curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, (long)CURL_HTTP_VERSION_2TLS);
+            // wait for a connection that might multiplex rather than opening another one
+            curl_easy_setopt(curl, CURLOPT_PIPEWAIT, 1L);
+        } else {
+            curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, (long)CURL_HTTP_VERSION_1_1);
+        }
+        if (options.compression) {
+            // an empty list offers every encoding libcurl was built with; it decodes the body as it
+            // streams in, so the write callback (and the parser behind it) only ever sees plain JSON
+            curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, "");
+        }
+        if (!options.ca_file.empty()) {
+            curl_easy_setopt(curl, CURLOPT_CAINFO, options.ca_file.c_str());
+        }
+        if (share) {
+            curl_easy_setopt(curl, CURLOPT_SHARE, share);
+        } else {
+            // the multi handle keeps a connection cache of its own, which would reuse them anyway
+            curl_easy_setopt(curl, CURLOPT_FORBID_REUSE, 1L);
+        }
+    }
 
-        curl_easy_cleanup(curl);
+    return curl;
+}
 
-        if (response != CURLE_OK) {
-            std::cerr << "Request failed: " << curl_easy_strerror(response) << std::endl;
-        }
+/**
+ * @brief Returns a handle to the pool once its request is done.
+ *
+ * Without connection reuse the handle (and with it, its connection) is thrown away instead.
+ */
+void HttpClient::release_handle(CURL* curl) {
+    if (!options.reuse_connections) {
+        curl_easy_cleanup(curl);
+        return;
     }
 
+    std::lock_guard<std::mutex> lock(pool_mutex);
+    idle_handles.push_back(curl);
+}
+
+void HttpClient::lock_share(CURL*, curl_lock_data data, curl_lock_access, void* userp) {
+    ((HttpClient*)userp)->share_mutexes[data].lock();
+}
+
+void HttpClient::unlock_share(CURL*, curl_lock_data data, void* userp) {
+    ((HttpClient*)userp)->share_mutexes[data].unlock();
+}
+
+/**
+ * @brief Returns the client used by the free request functions, created on first use.
+ */
+static HttpClient& default_client() {
+    static RateLimiter rate_limiter;
+    static HttpClient client([]() {
+        HttpClientOptions options;
+        options.rate_limiter = &rate_limiter;
+        return options;
+    }());
+    return client;
+}
+
+/**
+ * @brief Builds and sends a GET request to the given API endpoint and returns JSON response data.
+ *
+ * @param endpoint  The API endpoint to make a request to.
+ * @return          The response body (in JSON);
+ */
+std::string get_json_response(const std::string& endpoint) {
+    std::string read_buffer;
+
+    default_client().get(endpoint, [&](const char* data, size_t size) {
+        read_buffer.append(data, size);
+    });
+
     return read_buffer;
 }
+
+/**
+ * @brief Builds and sends a GET request to the given API endpoint, passing the response body on as it arrives.
+ *
+ * @param endpoint  The API endpoint to make a request to.
+ * @param on_data   Called with each chunk of the response body as soon as libcurl receives it.
+ * @return          Whether the transfer completed.
+ */
+bool stream_json_response(const std::string& endpoint, DataCallback on_data) {
+    return default_client().get(endpoint, std::move(on_data));
+}
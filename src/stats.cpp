@@ -0,0 +1,168 @@
+#include <algorithm>
+#include <charconv>
+#include <utility>
+
+#include "stats.hpp"
+
+namespace {
+
+// the FNV-1a hash of a repository's name
+std::uint64_t hash_name(std::string_view name) {
+    std::uint64_t hash = 14695981039346656037ull;
+    for (const char c : name) {
+        hash = (hash ^ (unsigned char)c) * 1099511628211ull;
+    }
+    return hash;
+}
+
+// a count right-aligned in a column, then the name it's for
+void append_row(std::string& out, std::uint64_t count, std::string_view name) {
+    char digits[24];
+    const auto result = std::to_chars(digits, digits + sizeof(digits), count);
+    const size_t length = result.ptr - digits;
+    if (length < 8) out.append(8 - length, ' ');
+    out.append(digits, length);
+    out += "  ";
+    out += name;
+    out += '\n';
+}
+
+// rows sorted by count, most first, then by name
+void append_section(std::string& out, std::string_view title, std::vector<std::pair<std::uint64_t, std::string_view>>& rows) {
+    std::sort(rows.begin(), rows.end(), [](const auto& a, const auto& b) {
+        return (a.first != b.first) ? a.first > b.first : a.second < b.second;
+    });
+
+    out += '\n';
+    out += title;
+    out += ":\n";
+    for (const auto& [count, name] : rows) {
+        append_row(out, count, name);
+    }
+}
+
+}  // namespace
+
+/**
+ * @brief Counts an event.
+ */
+void ActivityStats::add(const EventView& event) {
+    ++event_count;
+
+    if (event.type == EventType::Unknown) {
+        const auto it = unknown_types.find(event.type_name);
+        if (it != unknown_types.end()) ++it->second;
+        else unknown_types.emplace(event.type_name, 1);
+    } else {
+        ++types[(size_t)event.type];
+    }
+
+    if (event.action == EventAction::Unknown) {
+        const auto it = unknown_actions.find(event.action_name);
+        if (it != unknown_actions.end()) ++it->second;
+        else unknown_actions.emplace(event.action_name, 1);
+    } else {
+        ++actions[(size_t)event.action];
+    }
+
+    const std::int64_t second_of_day = ((event.time % 86400) + 86400) % 86400;
+    ++hours[second_of_day / 3600];
+
+    if (event.type == EventType::Push && event.commit_count) {
+        commit_count += *event.commit_count;
+    }
+
+    count_repo(event.repo_name, hash_name(event.repo_name), 1);
+}
+
+/**
+ * @brief Adds another thread's counts to these.
+ */
+void ActivityStats::merge(const ActivityStats& other) {
+    event_count += other.event_count;
+    commit_count += other.commit_count;
+    for (size_t i = 0; i < types.size(); ++i) types[i] += other.types[i];
+    for (size_t i = 0; i < actions.size(); ++i) actions[i] += other.actions[i];
+    for (size_t i = 0; i < hours.size(); ++i) hours[i] += other.hours[i];
+    for (const auto& [name, count] : other.unknown_types) unknown_types[name] += count;
+    for (const auto& [name, count] : other.unknown_actions) unknown_actions[name] += count;
+
+    for (const RepoSlot& slot : other.repo_slots) {
+        if (slot.count == 0) continue;
+        const std::string_view name(other.repo_names.data() + slot.name.offset, slot.name.length);
+        count_repo(name, slot.hash, slot.count);
+    }
+}
+
+/**
+ * @brief Renders the counts as text: the totals, then the events per type, repository and action
+ *        (most first), and per hour of the day.
+ */
+void ActivityStats::append_report(std::string& out) const {
+    std::vector<std::pair<std::uint64_t, std::string_view>> rows;
+
+    append_row(out, event_count, "events");
+    append_row(out, commit_count, "commits pushed");
+
+    for (size_t i = 0; i < types.size(); ++i) {
+        if (types[i] != 0) rows.emplace_back(types[i], to_string((EventType)i));
+    }
+    for (const auto& [name, count] : unknown_types) rows.emplace_back(count, name);
+    append_section(out, "by type", rows);
+
+    rows.clear();
+    for (const RepoSlot& slot : repo_slots) {
+        if (slot.count != 0) rows.emplace_back(slot.count, std::string_view(repo_names.data() + slot.name.offset, slot.name.length));
+    }
+    append_section(out, "by repository", rows);
+
+    rows.clear();
+    // events without an action aren't counted under one
+    for (size_t i = (size_t)EventAction::Unknown + 1; i < actions.size(); ++i) {
+        if (actions[i] != 0) rows.emplace_back(actions[i], to_string((EventAction)i));
+    }
+    for (const auto& [name, count] : unknown_actions) rows.emplace_back(count, name);
+    append_section(out, "by action", rows);
+
+    out += "\nby hour (UTC):\n";
+    for (size_t hour = 0; hour < hours.size(); ++hour) {
+        const char label[] = {(char)('0' + hour / 10), (char)('0' + hour % 10), ':', '0', '0'};
+        append_row(out, hours[hour], std::string_view(label, sizeof(label)));
+    }
+}
+
+void ActivityStats::count_repo(std::string_view name, std::uint64_t hash, std::uint64_t count) {
+    if ((repo_count + 1) * 2 > repo_slots.size()) {
+        grow_repos();
+    }
+
+    const size_t mask = repo_slots.size() - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+        RepoSlot& slot = repo_slots[i];
+        if (slot.count == 0) {
+            slot.hash = hash;
+            slot.count = count;
+            slot.name = {(std::uint32_t)repo_names.size(), (std::uint32_t)name.size()};
+            repo_names += name;
+            ++repo_count;
+            return;
+        }
+        if (slot.hash == hash && std::string_view(repo_names.data() + slot.name.offset, slot.name.length) == name) {
+            slot.count += count;
+            return;
+        }
+    }
+}
+
+void ActivityStats::grow_repos() {
+    std::vector<RepoSlot> old = std::move(repo_slots);
+    repo_slots.assign(std::max<size_t>(old.size() * 2, 64), RepoSlot());
+
+    const size_t mask = repo_slots.size() - 1;
+    for (const RepoSlot& slot : old) {
+        if (slot.count == 0) continue;
+        size_t i = slot.hash & mask;
+        while (repo_slots[i].count != 0) i = (i + 1) & mask;
+        repo_slots[i] = slot;
+    }
+}
@@ -0,0 +1,162 @@
+#include <charconv>
+
+#include "timestamp.hpp"
+
+namespace {
+
+// reads exactly `count` digits starting at `pos`
+bool read_digits(std::string_view text, size_t pos, size_t count, int& value) {
+    if (pos + count > text.size()) return false;
+
+    value = 0;
+    for (size_t i = pos; i < pos + count; ++i) {
+        const char c = text[i];
+        if (c < '0' || c > '9') return false;
+        value = value * 10 + (c - '0');
+    }
+    return true;
+}
+
+// days in the given month (1-12) of the given (proleptic Gregorian) year
+int days_in_month(int year, int month) {
+    static constexpr int days[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    const bool leap = year % 4 == 0 && (year % 100 != 0 || year % 400 == 0);
+    return (month == 2 && leap) ? 29 : days[month - 1];
+}
+
+// days between 1970-01-01 and the given (proleptic Gregorian) date
+std::int64_t days_from_civil(std::int64_t year, int month, int day) {
+    year -= month <= 2;
+    const std::int64_t era = (year >= 0 ? year : year - 399) / 400;
+    const std::int64_t year_of_era = year - era * 400;
+    const std::int64_t day_of_year = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    const std::int64_t day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+    return era * 146097 + day_of_era - 719468;
+}
+
+// the (proleptic Gregorian) date the given number of days after 1970-01-01 falls on
+void civil_from_days(std::int64_t days, std::int64_t& year, int& month, int& day) {
+    days += 719468;
+    const std::int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    const std::int64_t day_of_era = days - era * 146097;
+    const std::int64_t year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+    const std::int64_t day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+    const std::int64_t month_index = (5 * day_of_year + 2) / 153;  // counting from March
+
+    day = (int)(day_of_year - (153 * month_index + 2) / 5 + 1);
+    month = (int)(month_index < 10 ? month_index + 3 : month_index - 9);
+    year = year_of_era + era * 400 + (month <= 2);
+}
+
+// writes the last two digits of a number
+void write_two_digits(char* out, std::int64_t value) {
+    out[0] = (char)('0' + value / 10 % 10);
+    out[1] = (char)('0' + value % 10);
+}
+
+}  // namespace
+
+/**
+ * @brief Parses an ISO-8601 UTC timestamp, as Github formats `created_at`, into Unix epoch seconds.
+ *
+ * Accepts `YYYY-MM-DDTHH:MM:SSZ` (the trailing Z is optional) or just `YYYY-MM-DD`, which means
+ * midnight. The fields are read at fixed offsets, so this doesn't go near strptime or iostreams.
+ *
+ * @param text     The timestamp.
+ * @param seconds  Receives the seconds since 1970-01-01T00:00:00Z.
+ * @return         Whether the timestamp was well-formed.
+ */
+bool parse_timestamp(std::string_view text, std::int64_t& seconds) {
+    int year, month, day;
+    if (!read_digits(text, 0, 4, year) || text.size() < 10 || text[4] != '-' || !read_digits(text, 5, 2, month) ||
+        text[7] != '-' || !read_digits(text, 8, 2, day)) {
+        return false;
+    }
+
+    int hour = 0, minute = 0, second = 0;
+    if (text.size() > 10) {
+        if ((text[10] != 'T' && text[10] != ' ') || !read_digits(text, 11, 2, hour) || text.size() < 19 ||
+            text[13] != ':' || !read_digits(text, 14, 2, minute) || text[16] != ':' ||
+            !read_digits(text, 17, 2, second)) {
+            return false;
+        }
+        if (text.size() > 19 && !(text.size() == 20 && text[19] == 'Z')) {
+            return false;
+        }
+    }
+
+    if (month < 1 || month > 12 || day < 1 || day > days_in_month(year, month) || hour > 23 || minute > 59 ||
+        second > 60) {
+        return false;
+    }
+
+    seconds = days_from_civil(year, month, day) * 86400 + hour * 3600 + minute * 60 + second;
+    return true;
+}
+
+/**
+ * @brief Appends a time as an ISO-8601 UTC timestamp, `YYYY-MM-DDTHH:MM:SSZ`, the way Github formats `created_at`.
+ *
+ * @param out      The buffer to append to.
+ * @param seconds  Seconds since 1970-01-01T00:00:00Z.
+ */
+void append_timestamp(std::string& out, std::int64_t seconds) {
+    std::int64_t days = seconds / 86400;
+    std::int64_t time_of_day = seconds % 86400;
+    if (time_of_day < 0) {
+        time_of_day += 86400;
+        --days;
+    }
+
+    std::int64_t year;
+    int month, day;
+    civil_from_days(days, year, month, day);
+
+    if (year < 0 || year > 9999) {
+        // out of the format's range; not something Github will send
+        char digits[24];
+        out.append(digits, std::to_chars(digits, digits + sizeof(digits), seconds).ptr);
+        return;
+    }
+
+    char text[] = "YYYY-MM-DDTHH:MM:SSZ";
+    write_two_digits(text, year / 100);
+    write_two_digits(text + 2, year);
+    write_two_digits(text + 5, month);
+    write_two_digits(text + 8, day);
+    write_two_digits(text + 11, time_of_day / 3600);
+    write_two_digits(text + 14, time_of_day / 60 % 60);
+    write_two_digits(text + 17, time_of_day % 60);
+    out.append(text, sizeof(text) - 1);
+}
+
+/**
+ * @brief Appends how long ago something happened, e.g. "2h ago", to a buffer.
+ *
+ * @param out          The buffer to append to.
+ * @param seconds_ago  Seconds since it happened; anything under a minute (or in the future) is "just now".
+ */
+void append_relative_time(std::string& out, std::int64_t seconds_ago) {
+    static constexpr struct {
+        std::int64_t seconds;
+        const char* suffix;
+    } units[] = {
+        {365 * 86400, "y ago"},
+        {30 * 86400, "mo ago"},
+        {86400, "d ago"},
+        {3600, "h ago"},
+        {60, "m ago"}
+    };
+
+    for (const auto& unit : units) {
+        if (seconds_ago >= unit.seconds) {
+            char digits[24];
+            const auto result = std::to_chars(digits, digits + sizeof(digits), seconds_ago / unit.seconds);
+            out.append(digits, result.ptr);
+            out += unit.suffix;
+            return;
+        }
+    }
+
+    out += "just now";
+}
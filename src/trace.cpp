@@ -0,0 +1,173 @@
+#include <charconv>
+#include <stdexcept>
+
+#include "output.hpp"
+#include "trace.hpp"
+
+namespace {
+
+// small numbers for the threads, in the order they first record something
+std::atomic<int> next_thread_id{1};
+thread_local int thread_id = 0;
+
+int current_thread_id() {
+    if (thread_id == 0) thread_id = next_thread_id.fetch_add(1, std::memory_order_relaxed);
+    return thread_id;
+}
+
+void append_number(std::string& out, std::int64_t value) {
+    char digits[24];
+    const auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, result.ptr);
+}
+
+void append_key(std::string& out, std::string_view name) {
+    out += ",\"";
+    out += name;
+    out += "\":";
+}
+
+void append_args(std::string& out, std::initializer_list<TraceArg> args) {
+    for (const TraceArg& arg : args) {
+        append_key(out, arg.name);
+        if (arg.is_text) append_json_string(out, arg.text);
+        else append_number(out, arg.number);
+    }
+}
+
+// the args as a JSON object of their own
+void append_args_object(std::string& out, std::initializer_list<TraceArg> args) {
+    out += '{';
+    const size_t first = out.size();
+    append_args(out, args);
+    if (out.size() > first) out.erase(first, 1);  // the first arg's comma
+    out += '}';
+}
+
+// the start of a Trace Event Format event, up to its timestamp
+void append_chrome_event(std::string& out, std::string_view name, char phase, std::uint64_t async_id,
+                         std::int64_t timestamp) {
+    out += "{\"name\":";
+    append_json_string(out, name);
+    out += ",\"cat\":\"github-activity\",\"ph\":\"";
+    out += phase;
+    out += '"';
+    if (async_id != 0) {
+        append_key(out, "id");
+        append_number(out, (std::int64_t)async_id);
+    }
+    out += ",\"pid\":1";
+    append_key(out, "tid");
+    append_number(out, current_thread_id());
+    append_key(out, "ts");
+    append_number(out, timestamp);
+}
+
+}  // namespace
+
+/**
+ * @brief Looks up a trace format by its name on the command line (jsonl or chrome).
+ */
+std::optional<TraceFormat> trace_format_from_string(std::string_view name) {
+    if (name == "jsonl") return TraceFormat::Jsonl;
+    if (name == "chrome") return TraceFormat::Chrome;
+    return std::nullopt;
+}
+
+/**
+ * @brief Creates (or truncates) the trace file.
+ *
+ * @param path    Where to write the records.
+ * @param format  What to write them as.
+ */
+Tracer::Tracer(const std::string& path, TraceFormat format)
+    : format(format), file(path, std::ios::binary | std::ios::trunc), started(Clock::now()) {
+    if (!file) {
+        throw std::runtime_error("couldn't open " + path);
+    }
+    if (format == TraceFormat::Chrome) {
+        // the JSON Array Format, whose closing bracket may be missing if the run is interrupted
+        file << "[\n";
+    }
+}
+
+Tracer::~Tracer() {
+    if (format == TraceFormat::Chrome) {
+        file << "\n]\n";
+    }
+}
+
+/**
+ * @brief Records a span that doesn't overlap any other span recorded on the calling thread.
+ *
+ * @param name      What was done, e.g. "parse".
+ * @param start     When it started.
+ * @param duration  How long it took.
+ * @param args      What it was done to, and how much of it there was.
+ */
+void Tracer::span(std::string_view name, Clock::time_point start, Clock::duration duration,
+                  std::initializer_list<TraceArg> args) {
+    record(name, start, duration, args, false);
+}
+
+/**
+ * @brief Records a span that may overlap others on the calling thread, such as a transfer.
+ */
+void Tracer::async_span(std::string_view name, Clock::time_point start, Clock::duration duration,
+                        std::initializer_list<TraceArg> args) {
+    record(name, start, duration, args, true);
+}
+
+/**
+ * @brief Writes out the records made so far, e.g. at the end of a watch poll.
+ */
+void Tracer::flush() {
+    std::lock_guard<std::mutex> lock(file_mutex);
+    file.flush();
+}
+
+void Tracer::record(std::string_view name, Clock::time_point start, Clock::duration duration,
+                    std::initializer_list<TraceArg> args, bool async) {
+    using std::chrono::duration_cast;
+    using std::chrono::microseconds;
+
+    const std::int64_t timestamp = duration_cast<microseconds>(start - started).count();
+    const std::int64_t length = duration_cast<microseconds>(duration).count();
+    std::string line;
+
+    if (format == TraceFormat::Jsonl) {
+        line += "{\"name\":";
+        append_json_string(line, name);
+        append_key(line, "ts_us");
+        append_number(line, timestamp);
+        append_key(line, "dur_us");
+        append_number(line, length);
+        append_key(line, "thread");
+        append_number(line, current_thread_id());
+        append_args(line, args);
+        line += "}\n";
+    } else if (!async) {
+        append_chrome_event(line, name, 'X', 0, timestamp);
+        append_key(line, "dur");
+        append_number(line, length);
+        line += ",\"args\":";
+        append_args_object(line, args);
+        line += '}';
+    } else {
+        // a begin and an end event, tied together by their id
+        const std::uint64_t id = next_async_id.fetch_add(1, std::memory_order_relaxed);
+        append_chrome_event(line, name, 'b', id, timestamp);
+        line += ",\"args\":";
+        append_args_object(line, args);
+        line += "},\n";
+        append_chrome_event(line, name, 'e', id, timestamp + length);
+        line += '}';
+    }
+
+    std::lock_guard<std::mutex> lock(file_mutex);
+    if (format == TraceFormat::Chrome && !first) {
+        file << ",\n";
+    }
+    first = false;
+    file << line;
+}
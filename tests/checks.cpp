@@ -0,0 +1,450 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <deque>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "arena.hpp"
+#include "cache.hpp"
+#include "fetching.hpp"
+#include "output.hpp"
+#include "parsing.hpp"
+#include "rate_limiter.hpp"
+#include "requests.hpp"
+#include "server.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+static int checks_run = 0;
+static int checks_failed = 0;
+
+/**
+ * @brief Records the outcome of one check, reporting it if it failed.
+ */
+static void check(bool passed, const char* what, const char* file, int line) {
+    ++checks_run;
+    if (!passed) {
+        ++checks_failed;
+        std::cout << file << ":" << line << ": check failed: " << what << std::endl;
+    }
+}
+
+#define CHECK(condition) check((condition), #condition, __FILE__, __LINE__)
+
+/**
+ * @brief A response carrying the rate-limit headers the API sends with every response.
+ *
+ * @param reset  When the window ends, in seconds since the Unix epoch.
+ */
+static LocalServer::Response rate_limit_response(int status, std::int64_t remaining, std::int64_t reset,
+                                                 std::string body) {
+    LocalServer::Response response;
+    response.status = status;
+    response.headers = {{"x-ratelimit-limit", "5000"},
+                        {"x-ratelimit-remaining", std::to_string(remaining)},
+                        {"x-ratelimit-reset", std::to_string(reset)}};
+    response.body = std::move(body);
+    return response;
+}
+
+/**
+ * @brief What a request passed on: the status, its headers and its body.
+ */
+struct Received {
+    HttpResult result;
+    std::vector<std::pair<std::string, std::string>> headers;
+    std::string body;
+
+    int count_header(std::string_view name) const {
+        int count = 0;
+        for (const auto& [header_name, value] : headers) {
+            count += header_name == name;
+        }
+        return count;
+    }
+};
+
+static Received fetch(HttpClient& client, const std::string& endpoint) {
+    Received received;
+    HttpRequest request;
+    request.endpoint = endpoint;
+    request.on_data = [&](const char* data, size_t size) { received.body.append(data, size); };
+    request.on_header = [&](std::string_view name, std::string_view value) { received.headers.emplace_back(name, value); };
+    received.result = client.get(request);
+    return received;
+}
+
+// a 403 with quota left isn't a rate limit (no access to a repository, say): it's the response, headers and all
+static void check_forbidden_is_not_retried() {
+    LocalServer server;
+    server.set_handler([](const LocalServer::Request&) {
+        return rate_limit_response(403, 4000, std::time(nullptr) + 3600, R"({"message":"Forbidden"})");
+    });
+
+    RateLimiter rate_limiter;
+    HttpClientOptions options;
+    options.rate_limiter = &rate_limiter;
+    HttpClient client(options);
+    const Received received = fetch(client, server.url() + "/users/alice/events");
+
+    CHECK(received.result.ok);
+    CHECK(received.result.status == 403);
+    CHECK(server.requests() == 1);
+    CHECK(received.body == R"({"message":"Forbidden"})");
+    CHECK(received.count_header("x-ratelimit-remaining") == 1);
+}
+
+// a 403 with no quota left is the primary rate limit: it's retried once the window resets, and only the retry is passed on
+static void check_exhausted_quota_is_retried() {
+    LocalServer server;
+    std::atomic<int> requests = 0;
+    server.set_handler([&](const LocalServer::Request&) {
+        if (requests++ == 0) {
+            return rate_limit_response(403, 0, std::time(nullptr) + 1, R"({"message":"API rate limit exceeded"})");
+        }
+        return rate_limit_response(200, 4999, std::time(nullptr) + 3600, "[]");
+    });
+
+    RateLimiter rate_limiter;
+    HttpClientOptions options;
+    options.rate_limiter = &rate_limiter;
+    HttpClient client(options);
+    const Received received = fetch(client, server.url() + "/users/alice/events");
+
+    CHECK(received.result.ok);
+    CHECK(received.result.status == 200);
+    CHECK(server.requests() == 2);
+    CHECK(received.body == "[]");
+    CHECK(received.count_header("x-ratelimit-remaining") == 1);
+}
+
+// a 429 is a secondary rate limit: the retry waits for at least as long as its Retry-After asks
+static void check_retry_after_is_waited_for() {
+    LocalServer server;
+    std::atomic<int> requests = 0;
+    server.set_handler([&](const LocalServer::Request&) {
+        LocalServer::Response response = rate_limit_response(200, 4999, std::time(nullptr) + 3600, "[]");
+        if (requests++ == 0) {
+            response.status = 429;
+            response.headers.emplace_back("retry-after", "1");
+            response.body = R"({"message":"You have exceeded a secondary rate limit"})";
+        }
+        return response;
+    });
+
+    RateLimiter rate_limiter;
+    HttpClientOptions options;
+    options.rate_limiter = &rate_limiter;
+    HttpClient client(options);
+    const Clock::time_point start = Clock::now();
+    const Received received = fetch(client, server.url() + "/users/alice/events");
+    const Clock::duration elapsed = Clock::now() - start;
+
+    CHECK(received.result.status == 200);
+    CHECK(server.requests() == 2);
+    CHECK(received.body == "[]");
+    CHECK(elapsed >= std::chrono::seconds(1));
+}
+
+// past a burst of RateLimiter::burst requests, the rest of the quota is spread over the window instead of spent at once
+static void check_quota_is_spread_after_burst() {
+    const int limit = 140;
+    const int request_count = 120;
+    const size_t max_in_flight = 4;
+    const std::int64_t reset = std::time(nullptr) + 3;
+
+    LocalServer server;
+    std::mutex arrivals_mutex;
+    std::vector<Clock::time_point> arrivals;
+    server.set_handler([&](const LocalServer::Request&) {
+        std::lock_guard<std::mutex> lock(arrivals_mutex);
+        arrivals.push_back(Clock::now());
+        return rate_limit_response(200, limit - (int)arrivals.size(), reset, "[]");
+    });
+
+    RateLimiter rate_limiter;
+    HttpClientOptions options;
+    options.rate_limiter = &rate_limiter;
+    HttpClient client(options);
+    std::deque<HttpRequest> requests;
+    int completed = 0;
+    for (int i = 0; i < request_count; ++i) {
+        HttpRequest& request = requests.emplace_back();
+        request.endpoint = server.url() + "/users/user" + std::to_string(i) + "/events";
+        request.on_data = [](const char*, size_t) {};
+        request.on_complete = [&](const HttpResult& result) { completed += result.status == 200; };
+    }
+    client.get_all(requests, max_in_flight);
+
+    CHECK(completed == request_count);
+    CHECK((int)arrivals.size() == request_count);
+    if ((int)arrivals.size() == request_count) {
+        // the first window's worth go out before the quota is known, then a burst spends the bucket, and the
+        // last few wait for tokens: under 40 requests left over 2-3 seconds is one every 60 ms or so
+        const int paced = 8;
+        CHECK(arrivals.back() - arrivals[request_count - paced] >= std::chrono::milliseconds(200));
+    }
+}
+
+// in watch mode, the users read longest ago are requested first, but still handed on in input order
+static void check_stalest_users_first() {
+    LocalServer server;
+    std::mutex targets_mutex;
+    std::vector<std::string> targets;
+    server.set_handler([&](const LocalServer::Request& request) {
+        std::lock_guard<std::mutex> lock(targets_mutex);
+        targets.push_back(request.target);
+        return LocalServer::Response{200, {}, "[]"};
+    });
+
+    HttpClient client;
+    FetchOptions options;
+    options.api_url = server.url();
+    options.max_in_flight = 1;
+    options.last_read = {300, 0, 200, 100};
+    EventFetcher fetcher(client, options);
+    std::vector<size_t> done;
+    fetcher.fetch({"alice", "bob", "carol", "dave"}, {
+        nullptr,
+        [](size_t, const EventView&) { return true; },
+        [&](size_t user, bool, const std::string&) { done.push_back(user); }
+    });
+
+    CHECK((targets == std::vector<std::string>{"/users/bob/events", "/users/dave/events", "/users/carol/events",
+                                               "/users/alice/events"}));
+    CHECK((done == std::vector<size_t>{0, 1, 2, 3}));
+}
+
+// a fetcher counts the requests it made, every page of every user, for the watch mode to pace its polls by
+static void check_requests_made_are_counted() {
+    LocalServer server;
+    server.set_handler([&](const LocalServer::Request& request) {
+        LocalServer::Response response;
+        response.body = "[]";
+        if (request.target.find("&page=1") != std::string::npos) {
+            const std::string path = request.target.substr(0, request.target.find('?'));
+            response.headers.emplace_back("link", "<" + server.url() + path + "?per_page=100&page=3>; rel=\"last\"");
+        }
+        return response;
+    });
+
+    HttpClient client;
+    FetchOptions options;
+    options.api_url = server.url();
+    options.all_pages = true;
+    EventFetcher fetcher(client, options);
+    fetcher.fetch({"alice", "bob"}, {});
+    CHECK(server.requests() == 6);
+    CHECK(fetcher.requests_made() == 6);
+
+    options.all_pages = false;
+    EventFetcher first_pages(client, options);
+    first_pages.fetch({"alice", "bob", "carol"}, {});
+    CHECK(first_pages.requests_made() == 3);
+}
+
+// over TLS, a client that trusts the server's certificate keeps its one connection for every request, and
+// one that doesn't trust it gets nothing
+static void check_https_connection_is_reused() {
+    LocalServer server(LocalServer::Scheme::Https);
+    server.set_body(R"([{"id":"1","type":"PublicEvent","repo":{"name":"alice/r"},"payload":{},)"
+                    R"("created_at":"2024-03-01T12:00:00Z"}])");
+    const std::string endpoint = server.url() + "/users/alice/events?per_page=100&page=1";
+    CHECK(endpoint.rfind("https://", 0) == 0);
+
+    HttpClientOptions options;
+    options.ca_file = server.certificate_file().string();
+    HttpClient client(options);
+    for (int i = 0; i < 3; ++i) {
+        const Received received = fetch(client, endpoint);
+        CHECK(received.result.ok);
+        CHECK(received.result.status == 200);
+        CHECK(received.body.find("PublicEvent") != std::string::npos);
+    }
+    CHECK(server.requests() == 3);
+    CHECK(server.connections() == 1);
+
+    HttpClient untrusting_client;
+    const Received refused = fetch(untrusting_client, endpoint);
+    CHECK(!refused.result.ok);
+    CHECK(refused.body.empty());
+    CHECK(server.requests() == 3);
+}
+
+/**
+ * @brief Creates an empty directory to cache responses in, for a check to remove again.
+ */
+static std::filesystem::path make_cache_directory() {
+    std::string path = (std::filesystem::temp_directory_path() / "github-activity-checks-XXXXXX").string();
+    if (!mkdtemp(path.data())) {
+        throw std::runtime_error("couldn't create a cache directory");
+    }
+    return path;
+}
+
+/**
+ * @brief Fetches a user's events and renders them as text, a line per event.
+ *
+ * @return  The lines, or nothing if the events couldn't be read.
+ */
+static std::string fetch_lines(HttpClient& client, const FetchOptions& options) {
+    EventFetcher fetcher(client, options);
+    std::string lines;
+    bool read = false;
+    fetcher.fetch({"alice"}, {
+        nullptr,
+        [&](size_t, const EventView& event) {
+            append_event_record(lines, OutputFormat::Text, event, "alice", false, 0);
+            lines += '\n';
+            return true;
+        },
+        [&](size_t, bool ok, const std::string&) { read = ok; }
+    });
+    return read ? lines : "";
+}
+
+// a page that hasn't changed is revalidated with its ETag, and the 304 renders the same lines as the 200 did; a
+// page that has changed replaces what was cached
+static void check_unchanged_page_is_not_modified() {
+    const std::string page = R"([{"id":"2","type":"WatchEvent","repo":{"name":"alice/r"},"payload":{"action":"started"},)"
+                             R"("created_at":"2024-03-01T12:00:00Z"},)"
+                             R"({"id":"1","type":"ForkEvent","repo":{"name":"alice/r"},"payload":{},)"
+                             R"("created_at":"2024-03-01T11:00:00Z"}])";
+    const std::string changed_page = R"([{"id":"3","type":"PublicEvent","repo":{"name":"alice/s"},"payload":{},)"
+                                     R"("created_at":"2024-03-02T12:00:00Z"}])";
+    const std::filesystem::path directory = make_cache_directory();
+
+    LocalServer server;
+    server.set_body(page);
+    ResponseCache cache(directory.string());
+    HttpClientOptions client_options;
+    client_options.cache = &cache;
+    HttpClient client(client_options);
+    FetchOptions options;
+    options.api_url = server.url();
+    options.cache = &cache;
+
+    const std::string first = fetch_lines(client, options);
+    const std::string second = fetch_lines(client, options);
+    CHECK(!first.empty());
+    CHECK(second == first);
+    CHECK(server.requests() == 2);
+    CHECK(server.not_modified() == 1);
+
+    server.set_body(changed_page);
+    const std::string third = fetch_lines(client, options);
+    const std::string fourth = fetch_lines(client, options);
+    CHECK(!third.empty());
+    CHECK(third != first);
+    CHECK(fourth == third);
+    CHECK(server.not_modified() == 2);
+
+    // rewrites went through temporary files renamed over the old ones, none of which are left behind
+    size_t files = 0;
+    for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+        CHECK(entry.path().string().find(".tmp") == std::string::npos);
+        ++files;
+    }
+    CHECK(files > 0);
+
+    std::filesystem::remove_all(directory);
+}
+
+// an event whose created_at isn't a valid time fails its page, rather than passing for the oldest event there is
+static void check_bad_created_at_fails_page() {
+    LocalServer server;
+    server.set_body(R"([{"id":"2","type":"WatchEvent","repo":{"name":"alice/r"},"payload":{"action":"started"},)"
+                    R"("created_at":"2024-03-01T12:00:00Z"},)"
+                    R"({"id":"1","type":"ForkEvent","repo":{"name":"alice/r"},"payload":{},)"
+                    R"("created_at":"2024-02-30T12:00:00Z"}])");
+
+    HttpClient client;
+    FetchOptions options;
+    options.api_url = server.url();
+    EventFetcher fetcher(client, options);
+    std::vector<std::uint64_t> ids;
+    bool read = true;
+    std::string error;
+    fetcher.fetch({"alice"}, {
+        nullptr,
+        [&](size_t, const EventView& event) { ids.push_back(event.id); return true; },
+        [&](size_t, bool ok, const std::string& user_error) { read = ok; error = user_error; }
+    });
+
+    CHECK(!read);
+    CHECK(error == "invalid created_at: 2024-02-30T12:00:00Z");
+    CHECK((ids == std::vector<std::uint64_t>{2}));
+}
+
+// the stream parser accepts exactly the bodies the whole-page parser does, however they're split up
+static void check_stream_parser_accepts_what_page_parser_does() {
+    const std::string event = R"({"id":"1","type":"ForkEvent","repo":{"name":"alice/r"},"payload":{},)"
+                              R"("created_at":"2024-03-01T11:00:00Z"})";
+    const std::vector<std::string> bodies = {
+        "[]", " [ ] \n", "[" + event + "]", "[" + event + "," + event + "]", "[ " + event + " ,\n" + event + " ]\n",
+        R"({"message":"Not Found"})",
+        // malformed
+        "", "[", "]", "[,]", "[," + event + "]", "[" + event + ",]", "[" + event + event + "]",
+        "[" + event + ",," + event + "]", "[" + event + "] x", "[" + event + "],", "[] []", "[]]",
+        "[" + event + "]" + event, R"({"message":"Not Found"} {})", "[1]", "[[]]", "[null]", "{}[]",
+    };
+
+    for (const std::string& body : bodies) {
+        const bool page_ok = parse_json_response(body, [](const Event&) {}, nullptr);
+
+        std::string error;
+        EventStreamParser whole([](const Event&) {});
+        whole.feed(body.data(), body.size());
+        EventStreamParser bytewise([](const Event&) {});
+        for (const char& c : body) bytewise.feed(&c, 1);
+
+        const bool whole_ok = whole.finish(&error);
+        const bool bytewise_ok = bytewise.finish(&error);
+        if (whole_ok != page_ok || bytewise_ok != page_ok) {
+            std::cout << "mismatch on " << body << std::endl;
+        }
+        CHECK(whole_ok == page_ok);
+        CHECK(bytewise_ok == page_ok);
+    }
+}
+
+// a round that spilled grows the arena to hold it next time, but only up to max_capacity
+static void check_arena_growth_is_capped() {
+    ScratchArena arena;
+    CHECK(arena.resource().allocate(2 * ScratchArena::default_capacity) != nullptr);
+    arena.reset();
+    CHECK(arena.capacity() > 2 * ScratchArena::default_capacity);
+    CHECK(arena.capacity() <= ScratchArena::max_capacity);
+
+    // a huge page's worth spills to the heap without the buffer keeping its size
+    for (int round = 0; round < 3; ++round) {
+        CHECK(arena.resource().allocate(4 * ScratchArena::max_capacity) != nullptr);
+        arena.reset();
+        CHECK(arena.capacity() == ScratchArena::max_capacity);
+    }
+}
+
+int main() {
+    check_forbidden_is_not_retried();
+    check_exhausted_quota_is_retried();
+    check_retry_after_is_waited_for();
+    check_quota_is_spread_after_burst();
+    check_stalest_users_first();
+    check_requests_made_are_counted();
+    check_https_connection_is_reused();
+    check_unchanged_page_is_not_modified();
+    check_bad_created_at_fails_page();
+    check_stream_parser_accepts_what_page_parser_does();
+    check_arena_growth_is_capped();
+
+    std::cout << checks_run - checks_failed << " of " << checks_run << " checks passed" << std::endl;
+    return checks_failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}